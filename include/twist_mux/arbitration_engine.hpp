@@ -0,0 +1,441 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__ARBITRATION_ENGINE_HPP_
+#define TWIST_MUX__ARBITRATION_ENGINE_HPP_
+
+#include <twist_mux/deadline_scheduler.hpp>
+#include <twist_mux/lock_priority_index.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace twist_mux
+{
+class EventRecorder;
+
+/**
+ * @brief The ArbitrationEngine class keeps the arbitration state of all the
+ * velocity and lock handles of a mux, and caches the current winner and
+ * the effective lock priority.
+ *
+ * The cache is only recomputed when a lock changes its state, when the
+ * winner expires, or when a source that outranks the current winner
+ * publishes. When the current winner publishes again the decision is a
+ * single id compare.
+ *
+ * The expiry of each handle is a flag, flipped by update() when the
+ * deadline (stamp + timeout) of the handle passes, so the decisions never
+ * need to read the clock.
+ *
+ * The hot state is kept as a struct of arrays indexed by handle id: an
+ * arbitration pass only reads one byte of priority and one byte of flags
+ * per handle, so a scan over 32 handles touches a single cache line. Cold
+ * data, like names, topics and subscriptions, stays in the topic handles.
+ *
+ * Times are in nanoseconds, as rcl_time_point_value_t, so the engine does
+ * not depend on rclcpp.
+ *
+ * Velocity handles can be grouped: the handles of a group arbitrate among
+ * themselves by their priority, and only the winner of each group competes
+ * with the ungrouped handles, with the priority of the group, which is also
+ * the one compared with the lock priority. A message then only rescans its
+ * own group, and only a change of group winner rescans the top level.
+ *
+ * With an EventRecorder, every operation that changes the state, and every
+ * change of winner, is recorded, so the trace can be replayed offline.
+ */
+class ArbitrationEngine
+{
+public:
+  typedef int priority_type;
+  typedef std::size_t handle_id;
+  typedef std::size_t group_id;
+  typedef std::int64_t time_type;
+
+  static constexpr handle_id NO_HANDLE = std::numeric_limits<handle_id>::max();
+  static constexpr group_id NO_GROUP = std::numeric_limits<group_id>::max();
+  static constexpr time_type NEVER = DeadlineScheduler::NEVER;
+
+  ArbitrationEngine();
+
+  /**
+   * @brief addGroup Registers a group of velocity handles
+   * @param priority Priority of the group
+   * @return Id of the new group
+   */
+  group_id addGroup(priority_type priority);
+
+  /**
+   * @brief addVelocity Registers a velocity handle
+   * @param priority Priority of the handle, within its group if it has one
+   * @param timeout Timeout in [ns]; <= 0 means the handle never expires
+   * @param group Group of the handle, or NO_GROUP
+   * @return Id of the new handle
+   */
+  handle_id addVelocity(priority_type priority, time_type timeout, group_id group = NO_GROUP);
+
+  /**
+   * @brief addLock Registers a lock handle
+   * @param priority Priority of the lock
+   * @param timeout Timeout in [ns]; <= 0 means the lock never expires
+   * @return Id of the new handle
+   */
+  handle_id addLock(priority_type priority, time_type timeout);
+
+  /**
+   * @brief remove Removes a handle from the arbitration; its id is not
+   * reused, and the messages it might still receive are ignored
+   * @param id Handle to remove
+   * @param now Current time
+   */
+  void remove(handle_id id, time_type now);
+
+  /**
+   * @brief setPriority Changes the priority of a handle
+   * @param id Handle
+   * @param priority New priority, within its group if it has one
+   * @param now Current time
+   */
+  void setPriority(handle_id id, priority_type priority, time_type now);
+
+  /**
+   * @brief setTimeout Changes the timeout of a handle, from its next message on
+   * @param id Handle
+   * @param timeout New timeout in [ns]; <= 0 means the handle never expires
+   */
+  void setTimeout(handle_id id, time_type timeout);
+
+  /**
+   * @brief setGroupPriority Changes the priority of a group
+   * @param group Group
+   * @param priority New priority
+   * @param now Current time
+   */
+  void setGroupPriority(group_id group, priority_type priority, time_type now);
+
+  /**
+   * @brief update Flips the expiry state of the handles whose deadline is
+   * before 'now'
+   * @param now Current time
+   */
+  void update(time_type now);
+
+  /**
+   * @brief expireNow Expires a handle before its deadline, e.g. when the
+   * middleware reports that its publishers missed their deadline or lost
+   * their liveliness; the next message refreshes it as usual
+   * @param id Handle to expire
+   * @param now Current time
+   */
+  void expireNow(handle_id id, time_type now);
+
+  /**
+   * @brief nextDeadline
+   * @return The earliest time at which update() might expire a handle
+   */
+  time_type nextDeadline() const
+  {
+    return deadlines_.nextDeadline();
+  }
+
+  /**
+   * @brief velocityReceived Updates the arbitration with a new velocity message
+   * @param id Velocity handle that received the message
+   * @param now Reception time
+   * @return true if the handle is the winner, i.e. its message must be published
+   */
+  bool velocityReceived(handle_id id, time_type now);
+
+  /**
+   * @brief lockReceived Updates the arbitration with a new lock message
+   * @param id Lock handle that received the message
+   * @param locked Content of the lock message
+   * @param now Reception time
+   */
+  void lockReceived(handle_id id, bool locked, time_type now);
+
+  /**
+   * @brief getWinner
+   * @return Id of the highest priority velocity handle that is not masked,
+   *         or NO_HANDLE if all of them are masked
+   */
+  handle_id getWinner();
+
+  /**
+   * @brief getLockPriority
+   * @return Highest priority of the locks that are locked (or expired),
+   *         kept up to date by the lock index without walking the locks
+   */
+  priority_type getLockPriority() const;
+
+  /**
+   * @brief hasExpired
+   * @return true if the handle has expired as of the last update();
+   *         handles without timeout never expire
+   */
+  bool hasExpired(handle_id id) const
+  {
+    return flags_[id] & EXPIRED;
+  }
+
+  /**
+   * @brief isLocked
+   * @return true if the lock has expired or is locked (i.e. bool message data is true)
+   */
+  bool isLocked(handle_id id) const
+  {
+    return flags_[id] & (EXPIRED | LOCKED);
+  }
+
+  /**
+   * @brief isMasked
+   * @return true if the velocity handle has expired, or its priority (the
+   *         one of its group if it has one) is below the lock priority
+   */
+  bool isMasked(handle_id id) const
+  {
+    return (flags_[id] & EXPIRED) || getTopPriority(id) < lock_priority_;
+  }
+
+  priority_type getPriority(handle_id id) const
+  {
+    return priority_[id];
+  }
+
+  /**
+   * @brief getTopPriority
+   * @return Priority the handle competes with against the ungrouped handles
+   *         and the locks: the priority of its group if it has one
+   */
+  priority_type getTopPriority(handle_id id) const
+  {
+    const auto group = group_[id];
+    return (group == NO_GROUP) ? priority_[id] : groups_[group].priority;
+  }
+
+  group_id getGroup(handle_id id) const
+  {
+    return group_[id];
+  }
+
+  std::size_t groups() const
+  {
+    return groups_.size();
+  }
+
+  /**
+   * @brief getDeadline
+   * @return Time after which the handle expires, or NEVER if it has no timeout
+   */
+  time_type getDeadline(handle_id id) const
+  {
+    return deadline_[id];
+  }
+
+  std::size_t size() const
+  {
+    return priority_.size();
+  }
+
+  /**
+   * @brief getWinnerSwitches
+   * @return Number of times the winner has changed, including to and from
+   *         NO_HANDLE
+   */
+  std::uint64_t getWinnerSwitches() const
+  {
+    return winner_switches_;
+  }
+
+  /**
+   * @brief getStateVersion
+   * @return Number of changes of the state the diagnostics report: handles
+   *         added, removed or reprioritized, changes of masking or locking,
+   *         and changes of winner; a copy of the engine with the same
+   *         version reports the same
+   */
+  std::uint64_t getStateVersion() const
+  {
+    return state_version_;
+  }
+
+  /**
+   * @brief getMaskedTime
+   * @param now Current time
+   * @return Time the velocity handle has been masked, or the lock has been
+   *         locked, since the first update of the engine; in [ns]
+   */
+  time_type getMaskedTime(handle_id id, time_type now) const;
+
+  /**
+   * @brief getWinnerTime
+   * @param now Current time
+   * @return Time the velocity handle has been the winner since the first
+   *         update of the engine; in [ns]
+   */
+  time_type getWinnerTime(handle_id id, time_type now) const;
+
+  /**
+   * @brief setRecorder Records the operations from now on
+   * @param recorder Recorder, which must outlive the engine, or nullptr to stop
+   */
+  void setRecorder(EventRecorder * recorder)
+  {
+    recorder_ = recorder;
+  }
+
+private:
+  /**
+   * @brief Flags of each handle
+   */
+  enum : std::uint8_t
+  {
+    LOCK = 1 << 0,     ///< The handle is a lock, otherwise a velocity
+    EXPIRED = 1 << 1,  ///< The deadline of the handle has passed
+    LOCKED = 1 << 2,   ///< Last lock message data
+    REMOVED = 1 << 3   ///< The handle was removed; a velocity is also EXPIRED
+  };
+
+  handle_id add(priority_type priority, time_type timeout, bool is_lock, group_id group);
+
+  /**
+   * @brief advance Moves the time of the engine, starting the time accounting
+   * on the first call
+   */
+  void advance(time_type now);
+
+  /**
+   * @brief setMasked Accounts the time masked (or locked) of a handle on a
+   * change of its state
+   */
+  void setMasked(handle_id id, bool masked, time_type now);
+
+  void setWinner(handle_id id, time_type now);
+
+  /**
+   * @brief expireDue Expires the handles whose deadline is before 'now',
+   * as update() does, without recording it
+   */
+  void expireDue(time_type now);
+
+  /**
+   * @brief arbitrate Implements velocityReceived()
+   */
+  bool arbitrate(handle_id id, time_type now);
+
+  /**
+   * @brief refresh Clears the expiry of a handle that received a message
+   * and moves its deadline
+   */
+  void refresh(handle_id id, time_type now);
+
+  void expire(handle_id id);
+
+  /**
+   * @brief updateLockPriority Takes the lock priority from the lock index,
+   * and invalidates the winner if it changed
+   */
+  void updateLockPriority(time_type now);
+
+  /**
+   * @brief outranks
+   * @return true if the velocity handle 'id' wins over the current winner,
+   * by top priority; on equal priorities the handle registered first wins.
+   */
+  bool outranks(handle_id id) const;
+
+  /**
+   * @brief outranksInGroup
+   * @return true if the velocity handle 'id' wins over the group winner
+   * 'winner', by priority within the group
+   */
+  bool outranksInGroup(handle_id id, handle_id winner) const;
+
+  void recompute();
+
+  void recomputeGroup(group_id group);
+
+  /**
+   * @brief groupWinnerChanged Invalidates the winner if the new winner of
+   * the group might change it
+   */
+  void groupWinnerChanged(group_id group);
+
+  /// Hot state, read by the arbitration passes:
+  std::vector<std::uint8_t> priority_;
+  std::vector<std::uint8_t> flags_;
+
+  /// Warm state, only used when a handle is refreshed or expires:
+  std::vector<time_type> timeout_;
+  std::vector<time_type> deadline_;
+  std::vector<group_id> group_;
+
+  /**
+   * @brief The Group struct holds the cached winner of a group
+   */
+  struct Group
+  {
+    std::uint8_t priority;
+    std::vector<handle_id> members;
+    handle_id winner;
+    bool dirty;
+  };
+
+  /// Ungrouped velocity handles and groups, which compete for the winner:
+  std::vector<handle_id> top_level_;
+  std::vector<Group> groups_;
+
+  DeadlineScheduler deadlines_;
+  LockPriorityIndex locks_;
+
+  handle_id winner_;
+  priority_type lock_priority_;
+
+  /// The cached winner and lock priority must be recomputed:
+  bool dirty_;
+
+  /// Time accounting, which is only updated on changes of state:
+  std::vector<time_type> masked_time_;
+  std::vector<time_type> masked_since_;
+  std::vector<time_type> winner_time_;
+  time_type winner_since_;
+  time_type epoch_;
+  time_type now_;
+
+  std::uint64_t winner_switches_;
+  std::uint64_t state_version_;
+
+  EventRecorder * recorder_;
+};
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__ARBITRATION_ENGINE_HPP_
@@ -0,0 +1,196 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__DEADLINE_SCHEDULER_HPP_
+#define TWIST_MUX__DEADLINE_SCHEDULER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace twist_mux
+{
+/**
+ * @brief The DeadlineScheduler class is an indexed binary min-heap of
+ * deadlines, with at most one deadline per id.
+ *
+ * Rescheduling an id moves its entry in place, so the heap never holds
+ * more entries than ids, and checking whether something is due is O(1).
+ */
+class DeadlineScheduler
+{
+public:
+  typedef std::size_t id_type;
+  typedef std::int64_t time_type;
+
+  static constexpr time_type NEVER = std::numeric_limits<time_type>::max();
+
+  /**
+   * @brief schedule Sets (or moves) the deadline of an id
+   * @param id Id
+   * @param deadline Deadline
+   */
+  void schedule(id_type id, time_type deadline)
+  {
+    if (position_.size() <= id) {
+      position_.resize(id + 1, NOT_SCHEDULED);
+    }
+
+    auto pos = position_[id];
+    if (pos == NOT_SCHEDULED) {
+      pos = heap_.size();
+      heap_.push_back({deadline, id});
+      position_[id] = pos;
+      siftUp(pos);
+      return;
+    }
+
+    const auto old_deadline = heap_[pos].deadline;
+    heap_[pos].deadline = deadline;
+    if (deadline < old_deadline) {
+      siftUp(pos);
+    } else {
+      siftDown(pos);
+    }
+  }
+
+  /**
+   * @brief cancel Removes the deadline of an id, if any
+   * @param id Id
+   */
+  void cancel(id_type id)
+  {
+    if (id < position_.size() && position_[id] != NOT_SCHEDULED) {
+      remove(position_[id]);
+    }
+  }
+
+  bool isScheduled(id_type id) const
+  {
+    return id < position_.size() && position_[id] != NOT_SCHEDULED;
+  }
+
+  /**
+   * @brief nextDeadline
+   * @return The earliest deadline, or NEVER if nothing is scheduled
+   */
+  time_type nextDeadline() const
+  {
+    return heap_.empty() ? NEVER : heap_.front().deadline;
+  }
+
+  /**
+   * @brief expire Removes all the ids whose deadline is before 'now'
+   * @param now Current time
+   * @param on_expired Called with each expired id, in deadline order
+   */
+  template<typename F>
+  void expire(time_type now, F && on_expired)
+  {
+    while (!heap_.empty() && heap_.front().deadline < now) {
+      const auto id = heap_.front().id;
+      remove(0);
+      on_expired(id);
+    }
+  }
+
+private:
+  static constexpr std::size_t NOT_SCHEDULED = std::numeric_limits<std::size_t>::max();
+
+  struct Entry
+  {
+    time_type deadline;
+    id_type id;
+  };
+
+  void remove(std::size_t pos)
+  {
+    position_[heap_[pos].id] = NOT_SCHEDULED;
+
+    const auto last = heap_.size() - 1;
+    if (pos != last) {
+      heap_[pos] = heap_[last];
+      position_[heap_[pos].id] = pos;
+      heap_.pop_back();
+      siftDown(pos);
+      siftUp(pos);
+    } else {
+      heap_.pop_back();
+    }
+  }
+
+  void swap(std::size_t a, std::size_t b)
+  {
+    std::swap(heap_[a], heap_[b]);
+    position_[heap_[a].id] = a;
+    position_[heap_[b].id] = b;
+  }
+
+  void siftUp(std::size_t pos)
+  {
+    while (pos > 0) {
+      const auto parent = (pos - 1) / 2;
+      if (!(heap_[pos].deadline < heap_[parent].deadline)) {
+        break;
+      }
+      swap(pos, parent);
+      pos = parent;
+    }
+  }
+
+  void siftDown(std::size_t pos)
+  {
+    const auto size = heap_.size();
+    while (true) {
+      auto smallest = pos;
+      const auto left = 2 * pos + 1;
+      const auto right = left + 1;
+      if (left < size && heap_[left].deadline < heap_[smallest].deadline) {
+        smallest = left;
+      }
+      if (right < size && heap_[right].deadline < heap_[smallest].deadline) {
+        smallest = right;
+      }
+      if (smallest == pos) {
+        break;
+      }
+      swap(pos, smallest);
+      pos = smallest;
+    }
+  }
+
+  std::vector<Entry> heap_;
+  /// Position of each id in heap_:
+  std::vector<std::size_t> position_;
+};
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__DEADLINE_SCHEDULER_HPP_
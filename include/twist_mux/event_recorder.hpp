@@ -0,0 +1,193 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__EVENT_RECORDER_HPP_
+#define TWIST_MUX__EVENT_RECORDER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace twist_mux
+{
+class ArbitrationEngine;
+
+/**
+ * @brief The EventRecorder class writes the inputs and the decisions of an
+ * arbitration engine to a memory-mapped file, as fixed-size binary records,
+ * so a trace can be replayed offline through the same arbitration code.
+ *
+ * The file has two regions after its header: the setup region keeps every
+ * configuration record (handles and groups added, removed or changed) until
+ * it is full, and the event ring keeps the last 'capacity' events (messages,
+ * expiry updates, winner changes and publishes), overwriting the oldest.
+ * Every record has a global sequence number to merge both on reading.
+ *
+ * Writing a record is a copy into the mapping and an atomic store, with no
+ * system call; the kernel flushes the pages, so the trace survives a crash
+ * of the process. There must be a single writer, here the holder of the
+ * arbitration mutex.
+ */
+class EventRecorder
+{
+public:
+  typedef std::int64_t time_type;
+
+  /// Id of the records about no handle, e.g. no winner:
+  static constexpr std::uint32_t NO_ID = 0xFFFFFFFF;
+
+  enum Type : std::uint8_t
+  {
+    /// Setup records:
+    ADD_GROUP = 1,           ///< id: group, priority
+    ADD_VELOCITY = 2,        ///< id: handle, priority, value: timeout, arg: group
+    ADD_LOCK = 3,            ///< id: handle, priority, value: timeout
+    REMOVE = 4,              ///< id: handle
+    SET_PRIORITY = 5,        ///< id: handle, priority
+    SET_TIMEOUT = 6,         ///< id: handle, value: timeout
+    SET_GROUP_PRIORITY = 7,  ///< id: group, priority
+
+    /// Events:
+    VELOCITY = 16,           ///< id: handle, flag: the handle won
+    LOCK = 17,               ///< id: handle, flag: locked
+    UPDATE = 18,             ///< expiry of the handles whose deadline has passed
+    EXPIRE = 19,             ///< id: handle expired on an event
+    WINNER = 20,             ///< id: new winner, arg: previous winner
+    PUBLISH = 21             ///< id: winner, NO_ID if none (fail-safe), flag: pending
+  };
+
+  /**
+   * @brief The Record struct is a record of the file
+   */
+  struct Record
+  {
+    std::uint64_t sequence;
+    time_type stamp;
+    std::int64_t value;
+    std::uint32_t id;
+    std::uint32_t arg;
+    std::uint8_t type;
+    std::uint8_t flag;
+    std::uint16_t priority;
+    std::uint32_t reserved;
+  };
+  static_assert(sizeof(Record) == 40, "records must keep their size in the file");
+
+  /**
+   * @brief The Header struct is the beginning of the file
+   */
+  struct Header
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint64_t setup_capacity;
+    std::uint64_t capacity;
+    std::atomic<std::uint64_t> setup_count;
+    std::atomic<std::uint64_t> event_count;
+    std::atomic<std::uint64_t> setup_dropped;
+  };
+  static_assert(
+    std::atomic<std::uint64_t>::is_always_lock_free,
+    "the counters are shared through the mapping");
+
+  /**
+   * @brief EventRecorder Creates, or truncates, the file and maps it
+   * @param path Path of the file
+   * @param capacity Number of events kept
+   * @param setup_capacity Number of setup records kept
+   * @throw std::system_error if the file cannot be created or mapped
+   */
+  EventRecorder(
+    const std::string & path, std::size_t capacity,
+    std::size_t setup_capacity = 4096);
+  ~EventRecorder();
+
+  EventRecorder(const EventRecorder &) = delete;
+  EventRecorder & operator=(const EventRecorder &) = delete;
+
+  /**
+   * @brief record Writes a record
+   * @return The record written, so its flag can be set once the operation it
+   *         records is done, or nullptr if the setup region is full
+   */
+  Record * record(
+    Type type, time_type stamp, std::uint32_t id, std::uint32_t arg = 0,
+    std::uint16_t priority = 0, std::uint8_t flag = 0, std::int64_t value = 0);
+
+  /**
+   * @brief read Reads a file written by an EventRecorder
+   * @param path Path of the file
+   * @param setup_dropped Set to the number of setup records that did not fit
+   * @return Setup records and retained events, by sequence
+   * @throw std::runtime_error if the file cannot be read or is not a trace
+   */
+  static std::vector<Record> read(
+    const std::string & path, std::uint64_t * setup_dropped = nullptr);
+
+private:
+  Header * header_;
+  Record * setup_;
+  Record * events_;
+  std::size_t size_;
+  std::uint64_t sequence_;
+};
+
+/**
+ * @brief The ReplayResult struct summarizes the replay of a trace
+ */
+struct ReplayResult
+{
+  /// Records read, and those applied to the engine:
+  std::size_t records = 0;
+  std::size_t operations = 0;
+  /// Decisions of the engine that differ from the recorded ones:
+  std::size_t mismatches = 0;
+  /// Sequence of the first mismatch, if any:
+  std::uint64_t first_mismatch = 0;
+  /// Time from the first to the last event record in [ns]; the setup
+  /// records are left out, since the handles are added stamped 0:
+  EventRecorder::time_type span = 0;
+};
+
+/**
+ * @brief replay Feeds a trace through an arbitration engine, as fast as
+ * possible, and compares its decisions with the recorded ones.
+ * Only a trace whose ring did not wrap starts from the recorded state;
+ * otherwise the decisions can differ until the handles that were refreshed
+ * before the retained events receive a message or expire.
+ * @param records Records, as returned by EventRecorder::read()
+ * @param engine Engine to replay on, which must be new
+ */
+ReplayResult replay(const std::vector<EventRecorder::Record> & records, ArbitrationEngine & engine);
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__EVENT_RECORDER_HPP_
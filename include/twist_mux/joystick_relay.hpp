@@ -0,0 +1,108 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__JOYSTICK_RELAY_HPP_
+#define TWIST_MUX__JOYSTICK_RELAY_HPP_
+
+#include <twist_mux/velocity_control.hpp>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_action/rclcpp_action.hpp>
+#include <geometry_msgs/msg/twist.hpp>
+#include <std_msgs/msg/bool.hpp>
+#include <twist_mux_msgs/action/joy_priority.hpp>
+#include <twist_mux_msgs/action/joy_turbo.hpp>
+#include <visualization_msgs/msg/marker.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace twist_mux
+{
+/**
+ * @brief The JoystickRelay class scales the joystick twists from
+ * 'joy_vel_in' with the turbo steps and forwards them on 'joy_vel_out' while
+ * the joystick has priority, which it publishes on 'joy_priority' for the
+ * mux lock.
+ *
+ * The priority and the turbo steps are changed with the JoyPriority and
+ * JoyTurbo actions, as joy_teleop does not support services. It is the C++
+ * version of joystick_relay.py, so it can be loaded as a component next to
+ * the mux and deliver the commands intra-process.
+ */
+class JoystickRelay : public rclcpp::Node
+{
+public:
+  explicit JoystickRelay(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+  void forwardCommand(const geometry_msgs::msg::Twist & cmd);
+
+  void togglePriority();
+
+  bool hasPriority() const
+  {
+    return priority_.data;
+  }
+
+  const VelocityControl & getVelocityControl() const
+  {
+    return *velocity_control_;
+  }
+
+private:
+  template<typename ActionT>
+  typename rclcpp_action::Server<ActionT>::SharedPtr createActionServer(
+    const std::string & name, std::function<void()> callback);
+
+  void updateMarker();
+
+  std::unique_ptr<VelocityControl> velocity_control_;
+
+  std_msgs::msg::Bool priority_;
+  visualization_msgs::msg::Marker marker_;
+
+  rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr cmd_sub_;
+  rclcpp::Publisher<geometry_msgs::msg::Twist>::SharedPtr cmd_pub_;
+  rclcpp::Publisher<std_msgs::msg::Bool>::SharedPtr priority_pub_;
+  rclcpp::Publisher<visualization_msgs::msg::Marker>::SharedPtr marker_pub_;
+
+  /// Updates the marker when the robot does not receive velocities:
+  rclcpp::TimerBase::SharedPtr marker_timer_;
+
+  rclcpp_action::Server<twist_mux_msgs::action::JoyPriority>::SharedPtr priority_server_;
+  rclcpp_action::Server<twist_mux_msgs::action::JoyTurbo>::SharedPtr increase_server_;
+  rclcpp_action::Server<twist_mux_msgs::action::JoyTurbo>::SharedPtr decrease_server_;
+  rclcpp_action::Server<twist_mux_msgs::action::JoyTurbo>::SharedPtr angular_increase_server_;
+  rclcpp_action::Server<twist_mux_msgs::action::JoyTurbo>::SharedPtr angular_decrease_server_;
+  rclcpp_action::Server<twist_mux_msgs::action::JoyTurbo>::SharedPtr reset_server_;
+};
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__JOYSTICK_RELAY_HPP_
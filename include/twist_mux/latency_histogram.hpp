@@ -0,0 +1,163 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__LATENCY_HISTOGRAM_HPP_
+#define TWIST_MUX__LATENCY_HISTOGRAM_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace twist_mux
+{
+/**
+ * @brief The LatencyHistogram class records durations from the command
+ * callbacks without locking, so the diagnostics can collect them from
+ * another thread.
+ *
+ * Buckets are logarithmic, with 4 sub-buckets per power of two, so any
+ * duration, from 1 ns to centuries, is recorded with a relative error
+ * below 25% in a fixed array of counters.
+ */
+class LatencyHistogram
+{
+public:
+  typedef std::int64_t duration_type;
+
+  static constexpr std::size_t BUCKETS = 256;
+
+  /**
+   * @brief The Snapshot struct holds the durations recorded between two
+   * collect() of the histogram
+   */
+  struct Snapshot
+  {
+    std::array<std::uint64_t, BUCKETS> counts{};
+    std::uint64_t total = 0;
+    duration_type max = 0;
+
+    /**
+     * @brief percentile
+     * @param q Quantile in [0, 1]
+     * @return Upper bound of the bucket of the quantile, at most the max;
+     *         0 if nothing has been recorded
+     */
+    duration_type percentile(double q) const
+    {
+      if (total == 0) {
+        return 0;
+      }
+
+      const auto rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1));
+      std::uint64_t seen = 0;
+      for (std::size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (rank < seen) {
+          const auto upper = upperBound(i);
+          return upper < max ? upper : max;
+        }
+      }
+      return max;
+    }
+  };
+
+  LatencyHistogram()
+  : max_(0)
+  {
+    for (auto & count : counts_) {
+      count.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief record Records a duration; negative durations are recorded as 0
+   * @param duration Duration in [ns]
+   */
+  void record(duration_type duration)
+  {
+    if (duration < 0) {
+      duration = 0;
+    }
+
+    counts_[bucket(static_cast<std::uint64_t>(duration))].fetch_add(1, std::memory_order_relaxed);
+
+    auto max = max_.load(std::memory_order_relaxed);
+    while (max < duration &&
+      !max_.compare_exchange_weak(max, duration, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  /**
+   * @brief collect Takes the durations recorded since the last collect()
+   * @return Snapshot of the durations
+   */
+  Snapshot collect()
+  {
+    Snapshot snapshot;
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+      snapshot.counts[i] = counts_[i].exchange(0, std::memory_order_relaxed);
+      snapshot.total += snapshot.counts[i];
+    }
+    snapshot.max = max_.exchange(0, std::memory_order_relaxed);
+    return snapshot;
+  }
+
+  static std::size_t bucket(std::uint64_t duration)
+  {
+    if (duration < 4) {
+      return static_cast<std::size_t>(duration);
+    }
+
+    // Exponent, plus the two bits after the leading one:
+    const auto exponent = 63 - __builtin_clzll(duration);
+    const auto mantissa = (duration >> (exponent - 2)) & 3;
+    return static_cast<std::size_t>((exponent - 1) * 4 + mantissa);
+  }
+
+  static duration_type upperBound(std::size_t bucket)
+  {
+    if (bucket < 4) {
+      return static_cast<duration_type>(bucket);
+    }
+
+    const auto exponent = bucket / 4 + 1;
+    const auto mantissa = bucket % 4;
+    const auto upper = ((std::uint64_t(4) + mantissa + 1) << (exponent - 2)) - 1;
+    return static_cast<duration_type>(upper);
+  }
+
+private:
+  std::array<std::atomic<std::uint64_t>, BUCKETS> counts_;
+  std::atomic<duration_type> max_;
+};
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__LATENCY_HISTOGRAM_HPP_
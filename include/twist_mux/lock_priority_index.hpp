@@ -0,0 +1,113 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__LOCK_PRIORITY_INDEX_HPP_
+#define TWIST_MUX__LOCK_PRIORITY_INDEX_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace twist_mux
+{
+/**
+ * @brief The LockPriorityIndex class counts the locks that are active (locked
+ * or expired) per priority, with a 256-bit bitmap of the priorities with at
+ * least one active lock, so the effective lock priority is a search of the
+ * highest set bit instead of a walk over all the locks.
+ */
+class LockPriorityIndex
+{
+public:
+  typedef int priority_type;
+
+  static constexpr std::size_t PRIORITIES = 256;
+
+  LockPriorityIndex()
+  : count_{}, bits_{}
+  {
+  }
+
+  /**
+   * @brief add Adds an active lock
+   * @param priority Priority of the lock, in [0, 255]
+   */
+  void add(priority_type priority)
+  {
+    if (count_[priority]++ == 0) {
+      bits_[priority / 64] |= (std::uint64_t(1) << (priority % 64));
+    }
+  }
+
+  /**
+   * @brief remove Removes an active lock previously added
+   * @param priority Priority of the lock, in [0, 255]
+   */
+  void remove(priority_type priority)
+  {
+    if (--count_[priority] == 0) {
+      bits_[priority / 64] &= ~(std::uint64_t(1) << (priority % 64));
+    }
+  }
+
+  /**
+   * @brief highest
+   * @return Highest priority of the active locks, or 0 if there is none
+   */
+  priority_type highest() const
+  {
+    for (std::size_t word = bits_.size(); word-- > 0; ) {
+      if (bits_[word] != 0) {
+        return static_cast<priority_type>(64 * word + highestBit(bits_[word]));
+      }
+    }
+    return 0;
+  }
+
+private:
+  static unsigned highestBit(std::uint64_t word)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63u - static_cast<unsigned>(__builtin_clzll(word));
+#else
+    unsigned bit = 0;
+    while (word >>= 1) {
+      ++bit;
+    }
+    return bit;
+#endif
+  }
+
+  /// Active locks per priority:
+  std::array<std::uint32_t, PRIORITIES> count_;
+  std::array<std::uint64_t, PRIORITIES / 64> bits_;
+};
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__LOCK_PRIORITY_INDEX_HPP_
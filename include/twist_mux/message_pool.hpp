@@ -0,0 +1,110 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__MESSAGE_POOL_HPP_
+#define TWIST_MUX__MESSAGE_POOL_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp/message_memory_strategy.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace twist_mux
+{
+/**
+ * @brief The MessagePoolMemoryStrategy class lends the messages a
+ * subscription takes from a pool allocated up front, instead of allocating
+ * a new message for each one.
+ *
+ * A message is free when the pool holds its only reference, so a handle
+ * can keep the last message as long as it wants. If all the messages are in
+ * use, a new one is allocated, as the default strategy does.
+ */
+template<typename MessageT>
+class MessagePoolMemoryStrategy
+  : public rclcpp::message_memory_strategy::MessageMemoryStrategy<MessageT>
+{
+public:
+  explicit MessagePoolMemoryStrategy(std::size_t size)
+  : next_(0)
+  {
+    pool_.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      pool_.push_back(std::make_shared<MessageT>());
+    }
+  }
+
+  std::shared_ptr<MessageT> borrow_message() override
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (std::size_t i = 0; i < pool_.size(); ++i) {
+      auto & msg = pool_[next_];
+      next_ = (next_ + 1) % pool_.size();
+      if (msg.use_count() == 1) {
+        return msg;
+      }
+    }
+
+    return std::make_shared<MessageT>();
+  }
+
+  void return_message(std::shared_ptr<MessageT> & msg) override
+  {
+    msg.reset();
+  }
+
+private:
+  std::vector<std::shared_ptr<MessageT>> pool_;
+  std::size_t next_;
+
+  /// Messages might be taken concurrently from a reentrant callback group:
+  std::mutex mutex_;
+};
+
+/**
+ * @brief createMessageMemoryStrategy
+ * @param pool_size Number of messages of the pool, 0 for the default strategy
+ * @return Memory strategy for a subscription
+ */
+template<typename MessageT>
+typename rclcpp::message_memory_strategy::MessageMemoryStrategy<MessageT>::SharedPtr
+createMessageMemoryStrategy(std::size_t pool_size)
+{
+  if (pool_size == 0) {
+    return rclcpp::message_memory_strategy::MessageMemoryStrategy<MessageT>::create_default();
+  }
+  return std::make_shared<MessagePoolMemoryStrategy<MessageT>>(pool_size);
+}
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__MESSAGE_POOL_HPP_
@@ -65,6 +65,73 @@ void fetch_param(std::shared_ptr<rclcpp::Node> nh, const std::string & param_nam
   output = param.get_value<T>();
 }
 
+/**
+ * @brief fetch_param_or Like fetch_param, but uses a default value when the
+ * parameter is not set
+ */
+template<class T>
+void fetch_param_or(
+  std::shared_ptr<rclcpp::Node> nh, const std::string & param_name, T & output,
+  const T & default_value)
+{
+  rclcpp::Parameter param;
+  if (!nh->get_parameter(param_name, param)) {
+    output = default_value;
+    return;
+  }
+
+  output = param.get_value<T>();
+}
+
+/**
+ * @brief fetch_qos Reads the QoS settings under 'prefix' (depth,
+ * reliability, deadline, lifespan, liveliness and liveliness_lease_duration),
+ * keeping the ones of 'qos' for those not set
+ */
+inline void fetch_qos(
+  std::shared_ptr<rclcpp::Node> nh, const std::string & prefix,
+  rclcpp::QoS & qos)
+{
+  int depth = 0;
+  fetch_param_or(nh, prefix + ".depth", depth, 0);
+  if (depth > 0) {
+    qos.keep_last(static_cast<std::size_t>(depth));
+  }
+
+  std::string reliability;
+  fetch_param_or(nh, prefix + ".reliability", reliability, std::string());
+  if (reliability == "reliable") {
+    qos.reliable();
+  } else if (reliability == "best_effort") {
+    qos.best_effort();
+  } else if (!reliability.empty()) {
+    throw ParamsHelperException("invalid reliability '" + reliability + "' in " + prefix);
+  }
+
+  auto fetch_duration = [&nh, &prefix](const std::string & name, auto set) {
+      double seconds = 0.0;
+      fetch_param_or(nh, prefix + "." + name, seconds, 0.0);
+      if (seconds > 0.0) {
+        set(rclcpp::Duration::from_seconds(seconds));
+      }
+    };
+  fetch_duration("deadline", [&qos](const rclcpp::Duration & d) {qos.deadline(d);});
+  fetch_duration("lifespan", [&qos](const rclcpp::Duration & d) {qos.lifespan(d);});
+  fetch_duration(
+    "liveliness_lease_duration",
+    [&qos](const rclcpp::Duration & d) {qos.liveliness_lease_duration(d);});
+
+  std::string liveliness;
+  fetch_param_or(nh, prefix + ".liveliness", liveliness, std::string());
+  if (liveliness == "automatic") {
+    qos.liveliness(rclcpp::LivelinessPolicy::Automatic);
+  } else if (liveliness == "manual_by_topic") {
+    qos.liveliness(rclcpp::LivelinessPolicy::ManualByTopic);
+  } else if (!liveliness.empty()) {
+    throw ParamsHelperException("invalid liveliness '" + liveliness + "' in " + prefix);
+  }
+}
+
 }  // namespace twist_mux
 
 #endif  // TWIST_MUX__PARAMS_HELPERS_HPP_
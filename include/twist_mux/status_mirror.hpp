@@ -0,0 +1,170 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__STATUS_MIRROR_HPP_
+#define TWIST_MUX__STATUS_MIRROR_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace twist_mux
+{
+/**
+ * @brief The StatusMirror class mirrors the state of the mux into a POSIX
+ * shared-memory segment, so that processes outside ROS on the same host,
+ * e.g. a motor controller watchdog, know whether the mux is alive and what
+ * it outputs without a subscription.
+ *
+ * The status is protected by a seqlock: the writer makes the sequence odd,
+ * writes the status and makes it even again, and a reader retries while the
+ * sequence is odd or has changed during its copy. Neither side takes a lock
+ * or makes a system call, so readers can poll at kHz rates and never block
+ * the mux. A read gives up after READ_TIMEOUT, so that a writer which died
+ * in the middle of an update does not hang its readers. There must be a
+ * single writer, here the holder of the arbitration mutex.
+ */
+class StatusMirror
+{
+public:
+  /// Winner of the status when there is none:
+  static constexpr std::uint32_t NO_ID = 0xFFFFFFFF;
+  /// Time a read retries before it gives up, by default, in [ns]:
+  static constexpr std::int64_t READ_TIMEOUT = 1000000;
+
+  /**
+   * @brief The Status struct is the state mirrored
+   */
+  struct Status
+  {
+    /// Number of updates of the status, which only grows:
+    std::uint64_t sequence;
+    /// CLOCK_MONOTONIC time of the last update in [ns]:
+    std::int64_t heartbeat;
+    /// Position of the winner in the 'topics', as the id of ~/active_source
+    /// and the index of ~/statistics/sources, NO_ID if none:
+    std::uint32_t winner;
+    std::int32_t lock_priority;
+    /// Last twist published on the output:
+    double linear[3];
+    double angular[3];
+  };
+
+  static constexpr std::size_t WORDS = sizeof(Status) / sizeof(std::uint64_t);
+  static_assert(WORDS * sizeof(std::uint64_t) == sizeof(Status), "the status is copied by words");
+
+  /**
+   * @brief The Segment struct is the layout of the shared-memory segment
+   */
+  struct Segment
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t size;
+    /// Seqlock sequence, odd while the status is written:
+    std::atomic<std::uint64_t> lock;
+    /// Status, as words so that the concurrent copies are atomic:
+    std::atomic<std::uint64_t> words[WORDS];
+  };
+  static_assert(
+    std::atomic<std::uint64_t>::is_always_lock_free,
+    "the seqlock is shared through the mapping");
+
+  /**
+   * @brief StatusMirror Creates, or resets, the segment and maps it
+   * @param name Name of the segment, as for shm_open, e.g. "/twist_mux_status"
+   * @throw std::system_error if the segment cannot be created or mapped
+   */
+  explicit StatusMirror(const std::string & name);
+
+  /**
+   * @brief ~StatusMirror Unmaps and unlinks the segment; the readers that
+   * have it mapped keep the last status, whose heartbeat no longer advances
+   */
+  ~StatusMirror();
+
+  StatusMirror(const StatusMirror &) = delete;
+  StatusMirror & operator=(const StatusMirror &) = delete;
+
+  /**
+   * @brief update Writes a new status
+   * @param status Status, whose sequence and heartbeat are set here
+   */
+  void update(Status & status);
+
+  /**
+   * @brief tryRead Reads the status of a segment consistently, retrying while
+   * it is written
+   * @param segment Segment
+   * @param status Status read, left unchanged on failure
+   * @param timeout Time to retry for in [ns]
+   * @return false if the status was still written when the timeout expired,
+   * e.g. because the writer died in the middle of an update
+   */
+  static bool tryRead(
+    const Segment & segment, Status & status,
+    std::int64_t timeout = READ_TIMEOUT);
+
+private:
+  std::string name_;
+  Segment * segment_;
+  std::uint64_t sequence_;
+};
+
+/**
+ * @brief The StatusMirrorReader class maps the segment of a StatusMirror
+ * read-only, for the processes that watch the mux
+ */
+class StatusMirrorReader
+{
+public:
+  /**
+   * @throw std::system_error if the segment cannot be opened or mapped
+   * @throw std::runtime_error if it is not the segment of a StatusMirror
+   */
+  explicit StatusMirrorReader(const std::string & name);
+  ~StatusMirrorReader();
+
+  StatusMirrorReader(const StatusMirrorReader &) = delete;
+  StatusMirrorReader & operator=(const StatusMirrorReader &) = delete;
+
+  bool tryRead(
+    StatusMirror::Status & status,
+    std::int64_t timeout = StatusMirror::READ_TIMEOUT) const
+  {
+    return StatusMirror::tryRead(*segment_, status, timeout);
+  }
+
+private:
+  const StatusMirror::Segment * segment_;
+};
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__STATUS_MIRROR_HPP_
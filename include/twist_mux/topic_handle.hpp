@@ -37,35 +37,53 @@
 #define TWIST_MUX__TOPIC_HANDLE_HPP_
 
 #include <rclcpp/rclcpp.hpp>
+#include <builtin_interfaces/msg/time.hpp>
 #include <std_msgs/msg/bool.hpp>
 #include <geometry_msgs/msg/twist.hpp>
 #include <geometry_msgs/msg/twist_stamped.hpp>
 
+#include <twist_mux/arbitration_engine.hpp>
+#include <twist_mux/latency_histogram.hpp>
+#include <twist_mux/message_pool.hpp>
 #include <twist_mux/utils.hpp>
+#include <twist_mux/velocity_input.hpp>
 #include <twist_mux/twist_mux.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace twist_mux
 {
-template<typename T>
-class TopicHandle_
+/**
+ * @brief The TopicHandle class holds the configuration, the subscription and
+ * the statistics of a topic of the mux. The message type only matters to
+ * the subscription, in subscribe(), so the handles need no template and the
+ * mux stores them as a single type.
+ */
+class TopicHandle
 {
 public:
   // Not copy constructible
-  TopicHandle_(TopicHandle_ &) = delete;
-  TopicHandle_(const TopicHandle_ &) = delete;
+  TopicHandle(TopicHandle &) = delete;
+  TopicHandle(const TopicHandle &) = delete;
 
   // Not copy assignable
-  TopicHandle_ & operator=(TopicHandle_ &) = delete;
-  TopicHandle_ & operator=(const TopicHandle_ &) = delete;
+  TopicHandle & operator=(TopicHandle &) = delete;
+  TopicHandle & operator=(const TopicHandle &) = delete;
 
   typedef int priority_type;
 
   /**
-   * @brief TopicHandle_
+   * @brief TopicHandle
    * @param nh Node handle
    * @param name Name identifier
    * @param topic Topic name
@@ -73,16 +91,26 @@ public:
    * that initially the message stamp is set to 0.0, so the message has
    * expired
    * @param priority Priority of the topic
+   * @param qos QoS of the subscription; a missed deadline or a loss of
+   * liveliness reported by the middleware expires the handle
    */
-  TopicHandle_(
+  TopicHandle(
     const std::string & name, const std::string & topic, const rclcpp::Duration & timeout,
-    priority_type priority, TwistMux * mux)
+    priority_type priority, TwistMux * mux, const rclcpp::QoS & qos = rclcpp::SystemDefaultsQoS())
   : name_(name),
     topic_(topic),
     timeout_(timeout),
     priority_(clamp(priority, priority_type(0), priority_type(255))),
+    qos_(qos),
     mux_(mux),
-    stamp_(0)
+    id_(ArbitrationEngine::NO_HANDLE),
+    stamp_(0),
+    received_(0),
+    forwarded_(0),
+    lost_(0),
+    last_reception_(0),
+    interval_(0),
+    jitter_(0)
   {
     RCLCPP_INFO(
       mux_->get_logger(),
@@ -92,18 +120,18 @@ public:
       static_cast<int>(priority_));
   }
 
-  virtual ~TopicHandle_() = default;
+  virtual ~TopicHandle() = default;
 
   /**
    * @brief hasExpired
    * @return true if the message has expired; false otherwise.
    *         If the timeout is set to 0.0, this function always returns
-   *         false
+   *         false. The expiry is updated by the mux deadline scheduler,
+   *         so this does not read the clock
    */
   bool hasExpired() const
   {
-    return (timeout_.seconds() > 0.0) && (
-      (mux_->now().seconds() - stamp_.seconds()) > timeout_.seconds());
+    return mux_->getArbitration().hasExpired(id_);
   }
 
   const std::string & getName() const
@@ -121,6 +149,20 @@ public:
     return timeout_;
   }
 
+  const rclcpp::QoS & getQoS() const
+  {
+    return qos_;
+  }
+
+  /**
+   * @brief getPublisherCount
+   * @return Number of publishers matched by the subscription
+   */
+  std::size_t getPublisherCount() const
+  {
+    return subscriber_ ? subscriber_->get_publisher_count() : 0;
+  }
+
   /**
    * @brief getPriority Priority getter
    * @return Priority
@@ -130,92 +172,436 @@ public:
     return priority_;
   }
 
-  const T & getStamp() const
+  /**
+   * @brief getId Id of the handle in the mux arbitration engine
+   * @return Id
+   */
+  ArbitrationEngine::handle_id getId() const
+  {
+    return id_;
+  }
+
+  const rclcpp::Time & getStamp() const
   {
     return stamp_;
   }
 
-  const T & getMessage() const
+  /**
+   * @brief getReceived
+   * @return Number of messages received, which can be read from any thread
+   */
+  std::uint64_t getReceived() const
   {
-    return msg_;
+    return received_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief getForwarded
+   * @return Number of messages published on the output
+   */
+  std::uint64_t getForwarded() const
+  {
+    return forwarded_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief getLost
+   * @return Number of messages the middleware reported as lost, if it does
+   */
+  std::uint64_t getLost() const
+  {
+    return lost_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief getInterval Last time between two messages, in [ns]; guarded by
+   * the arbitration mutex
+   */
+  ArbitrationEngine::time_type getInterval() const
+  {
+    return interval_;
+  }
+
+  /**
+   * @brief getJitter Variation of the time between messages, in [ns],
+   * smoothed as the interarrival jitter of RFC 3550; guarded by the
+   * arbitration mutex
+   */
+  ArbitrationEngine::time_type getJitter() const
+  {
+    return jitter_;
+  }
+
+  /**
+   * @brief getAge Age of the stamped messages on reception, i.e. reception
+   * time minus header stamp; empty for messages without header
+   */
+  LatencyHistogram & getAge()
+  {
+    return age_;
+  }
+
+  /**
+   * @brief reconfigure Changes the timeout and the priority of the handle;
+   * called with the arbitration mutex held
+   */
+  void reconfigure(
+    const rclcpp::Duration & timeout, priority_type priority,
+    const rclcpp::Time & now)
+  {
+    timeout_ = timeout;
+    priority_ = clamp(priority, priority_type(0), priority_type(255));
+
+    auto & arbitration = mux_->getArbitration();
+    arbitration.setTimeout(id_, timeout_.nanoseconds());
+    if (arbitration.getPriority(id_) != priority_) {
+      arbitration.setPriority(id_, priority_, now.nanoseconds());
+    }
+  }
+
+  /**
+   * @brief remove Removes the handle from the arbitration; called with the
+   * arbitration mutex held
+   */
+  void remove(const rclcpp::Time & now)
+  {
+    mux_->getArbitration().remove(id_, now.nanoseconds());
+  }
+
+  /**
+   * @brief unsubscribe Stops the subscription, without the arbitration
+   * mutex, as destroying it takes a while
+   */
+  void unsubscribe()
+  {
+    subscriber_.reset();
   }
 
 protected:
   std::string name_;
   std::string topic_;
-  typename rclcpp::Subscription<T>::SharedPtr subscriber_;
+  rclcpp::SubscriptionBase::SharedPtr subscriber_;
   rclcpp::Duration timeout_;
   priority_type priority_;
+  rclcpp::QoS qos_;
 
 protected:
   TwistMux * mux_;
 
+  ArbitrationEngine::handle_id id_;
+
   rclcpp::Time stamp_;
-  T msg_;
-};
 
-template<typename T>
-class VelocityTopicHandle : public TopicHandle_<T>
-{
-private:
-  typedef TopicHandle_<T> base_type;
+  /**
+   * @brief subscribe Creates the subscription of the handle with 'qos', in
+   * the callback group of its group (the command callback group by default)
+   * and with the memory strategy of the mux; it replaces the previous one
+   * once created, so none of the messages in between is missed
+   */
+  template<typename T, typename CallbackT>
+  void subscribe(
+    CallbackT callback, const rclcpp::QoS & qos,
+    ArbitrationEngine::group_id group = ArbitrationEngine::NO_GROUP)
+  {
+    rclcpp::SubscriptionOptions options;
+    options.callback_group = mux_->getCallbackGroup(group);
+
+    // The events expire the handle as soon as the middleware knows, instead
+    // of when the timeout passes:
+    options.event_callbacks.deadline_callback =
+      [this](rclcpp::QOSDeadlineRequestedInfo &) {
+        mux_->expire(id_);
+      };
+    options.event_callbacks.liveliness_callback =
+      [this](rclcpp::QOSLivelinessChangedInfo & info) {
+        // Publishers leaving do not lose their liveliness:
+        if (info.not_alive_count_change > 0 && info.alive_count == 0) {
+          mux_->expire(id_);
+        }
+      };
+
+    options.event_callbacks.message_lost_callback =
+      [this](rclcpp::QOSMessageLostInfo & info) {
+        lost_.store(info.total_count, std::memory_order_relaxed);
+      };
+    options.event_callbacks.incompatible_qos_callback =
+      [this](rclcpp::QOSRequestedIncompatibleQoSInfo & info) {
+        RCLCPP_WARN(
+          mux_->get_logger(),
+          "Topic handler '%s' ignores a publisher with an incompatible QoS (policy %d).",
+          name_.c_str(), static_cast<int>(info.last_policy_kind));
+      };
+
+    try {
+      subscriber_ = mux_->template create_subscription<T>(
+        topic_, qos, callback, options,
+        createMessageMemoryStrategy<T>(mux_->getMessagePoolSize()));
+    } catch (const rclcpp::UnsupportedEventTypeException &) {
+      // Not every middleware reports lost messages or incompatible QoS:
+      options.event_callbacks.message_lost_callback = nullptr;
+      options.event_callbacks.incompatible_qos_callback = nullptr;
+      subscriber_ = mux_->template create_subscription<T>(
+        topic_, qos, callback, options,
+        createMessageMemoryStrategy<T>(mux_->getMessagePoolSize()));
+    }
+  }
 
-public:
-  using base_type::subscriber_;
-  using base_type::mux_;
-  using base_type::topic_;
-  using base_type::stamp_;
-  using base_type::msg_;
+  /**
+   * @brief received Updates the statistics with a new message, received at
+   * 'stamp_'
+   */
+  void received()
+  {
+    const auto now = stamp_.nanoseconds();
+    if (last_reception_ > 0) {
+      const auto interval = now - last_reception_;
+      const auto variation = std::abs(interval - interval_);
+      if (interval_ > 0) {
+        jitter_ += (variation - jitter_) / 16;
+      }
+      interval_ = interval;
+    }
+    last_reception_ = now;
 
-  typedef typename base_type::priority_type priority_type;
+    received_.fetch_add(1, std::memory_order_relaxed);
+  }
 
+  /// Statistics, read by the diagnostics without the arbitration mutex:
+  std::atomic<std::uint64_t> received_;
+  std::atomic<std::uint64_t> forwarded_;
+  std::atomic<std::uint64_t> lost_;
+  LatencyHistogram age_;
+
+  /// Statistics guarded by the arbitration mutex:
+  ArbitrationEngine::time_type last_reception_;
+  ArbitrationEngine::time_type interval_;
+  ArbitrationEngine::time_type jitter_;
+};
+
+/**
+ * @brief The VelocityTopicHandle class subscribes to a velocity topic of any
+ * input type with VelocityInputTraits, and keeps its last message as the
+ * command the mux arbitrates and publishes.
+ */
+class VelocityTopicHandle : public TopicHandle
+{
+public:
+  /**
+   * @param type Input type, as in VelocityInputTraits
+   * @param group Group of the handle, whose priority is then the one within
+   * the group
+   * @note The handle only subscribes in create()
+   */
   VelocityTopicHandle(
     const std::string & name, const std::string & topic, const rclcpp::Duration & timeout,
-    priority_type priority, TwistMux * mux)
-  : base_type(name, topic, timeout, priority, mux)
+    priority_type priority, TwistMux * mux, const std::string & type,
+    ArbitrationEngine::group_id group = ArbitrationEngine::NO_GROUP,
+    const rclcpp::QoS & qos = rclcpp::SystemDefaultsQoS())
+  : TopicHandle(name, topic, timeout, priority, mux, qos),
+    type_(type),
+    command_{nullptr, nullptr, nullptr},
+    masked_updates_(0),
+    masked_subscription_(false)
+  {
+    // A reconfiguration adds handles while the callbacks run:
+    std::lock_guard<std::mutex> lock(mux_->getArbitrationMutex());
+    id_ = mux_->getArbitration().addVelocity(priority_, timeout_.nanoseconds(), group);
+  }
+
+  /**
+   * @brief create Creates a handle subscribed to messages of type T
+   */
+  template<typename T>
+  static std::shared_ptr<VelocityTopicHandle> create(
+    const std::string & name, const std::string & topic, const rclcpp::Duration & timeout,
+    priority_type priority, TwistMux * mux,
+    ArbitrationEngine::group_id group = ArbitrationEngine::NO_GROUP,
+    const rclcpp::QoS & qos = rclcpp::SystemDefaultsQoS())
+  {
+    auto handle = std::make_shared<VelocityTopicHandle>(
+      name, topic, timeout, priority, mux, VelocityInputTraits<T>::type, group, qos);
+
+    VelocityTopicHandle * self = handle.get();
+    self->command_ = VelocityCommand::ofType<T>();
+    self->subscribe_ = [self, group](const rclcpp::QoS & qos) {
+        self->template subscribe<T>(
+          [self](const typename T::ConstSharedPtr msg) {self->callback(msg);}, qos, group);
+      };
+    self->subscribe_(qos);
+    return handle;
+  }
+
+  /**
+   * @brief setMaskedQoS Sets the QoS of the subscription while the handle
+   * stays masked, e.g. depth 1 and best effort, or none to always keep the
+   * one of the handle
+   */
+  void setMaskedQoS(const std::optional<rclcpp::QoS> & qos)
   {
-    subscriber_ = mux_->template create_subscription<T>(
-      topic_, rclcpp::SystemDefaultsQoS(),
-      std::bind(&VelocityTopicHandle::callback, this, std::placeholders::_1));
+    masked_qos_ = qos;
   }
 
-  bool isMasked(priority_type lock_priority) const
+  const std::optional<rclcpp::QoS> & getMaskedQoS() const
   {
-    // std::cout << hasExpired() << " / " << (getPriority() < lock_priority) << std::endl;
-    return base_type::hasExpired() || (base_type::getPriority() < lock_priority);
+    return masked_qos_;
   }
 
-  void callback(const typename T::ConstSharedPtr msg)
+  /**
+   * @brief hasMaskedSubscription
+   * @return true if subscribed with the masked QoS
+   */
+  bool hasMaskedSubscription() const
   {
-    stamp_ = mux_->now();
-    msg_ = *msg;
+    return masked_subscription_;
+  }
 
-    // Check if this twist has priority.
-    // Note that we have to check all the locks because they might time out
-    // and since we have several topics we must look for the highest one in
-    // all the topic list; so far there's no O(1) solution.
-    if (mux_->template hasPriority(*this)) {
-      mux_->template publishTwist(msg);
+  /**
+   * @brief updateMasked Samples whether the handle is masked; called
+   * periodically, with the arbitration mutex held
+   */
+  void updateMasked()
+  {
+    if (!isMasked()) {
+      masked_updates_ = 0;
+    } else if (masked_updates_ < MASKED_UPDATES) {
+      ++masked_updates_;
     }
   }
-};
 
-class LockTopicHandle : public TopicHandle_<std_msgs::msg::Bool>
-{
+  /**
+   * @brief updateSubscription Subscribes again with the masked QoS once the
+   * handle has been found masked by MASKED_UPDATES updates in a row, and with
+   * its own QoS as soon as it is not; called by the thread that calls
+   * updateMasked(), without the arbitration mutex as subscribing takes a
+   * while
+   */
+  void updateSubscription()
+  {
+    const bool masked = masked_qos_ && masked_updates_ >= MASKED_UPDATES;
+    if (masked == masked_subscription_) {
+      return;
+    }
+    masked_subscription_ = masked;
+
+    RCLCPP_DEBUG(
+      mux_->get_logger(), "Topic handler '%s' subscribed with its %s QoS.",
+      name_.c_str(), masked ? "masked" : "own");
+    subscribe_(masked ? *masked_qos_ : qos_);
+  }
+
+  /**
+   * @brief getType
+   * @return Input type of the topic, as in VelocityInputTraits
+   */
+  const std::string & getType() const
+  {
+    return type_;
+  }
+
+  /**
+   * @brief getCommand Last command received, which refers to the last
+   * message; guarded by the arbitration mutex
+   * @return Command, or nullptr if nothing has been received yet
+   */
+  const VelocityCommand * getCommand() const
+  {
+    return message_ ? &command_ : nullptr;
+  }
+
+  /**
+   * @brief isMasked
+   * @return true if has expired, or its priority (the one of its group if it
+   *         has one) is below the lock priority
+   */
+  bool isMasked() const
+  {
+    return mux_->getArbitration().isMasked(id_);
+  }
+
+  template<typename T>
+  void callback(const std::shared_ptr<const T> & msg)
+  {
+    // Measured from before the lock, as waiting for it is part of the cost:
+    const auto start = std::chrono::steady_clock::now();
+
+    {
+      std::lock_guard<std::mutex> lock(mux_->getArbitrationMutex());
+
+      // The message is only converted into the output when it is published;
+      // the handle just keeps a reference to it, which supersedes the
+      // previous one:
+      stamp_ = mux_->now();
+      message_ = msg;
+      command_.message = msg.get();
+
+      // Check if this twist has priority.
+      // The arbitration engine caches the winner, so this is O(1) unless a
+      // lock changed or a deadline passed since the last message.
+      if (mux_->hasPriority(*this)) {
+        mux_->publishTwist(*getCommand());
+        forwarded_.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      // Only the stamped inputs have a header:
+      const auto header_stamp = headerStamp(*msg, 0);
+      if (header_stamp.sec != 0 || header_stamp.nanosec != 0) {
+        age_.record((stamp_ - rclcpp::Time(header_stamp, stamp_.get_clock_type())).nanoseconds());
+      }
+
+      received();
+    }
+    mux_->flushOutput();
+
+    mux_->getCallbackLatency().record(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+  }
+
 private:
-  typedef TopicHandle_<std_msgs::msg::Bool> base_type;
+  template<typename T>
+  static auto headerStamp(const T & msg, int)->decltype(msg.header.stamp)
+  {
+    return msg.header.stamp;
+  }
 
-public:
-  typedef typename base_type::priority_type priority_type;
+  template<typename T>
+  static builtin_interfaces::msg::Time headerStamp(const T &, long)
+  {
+    return builtin_interfaces::msg::Time();
+  }
+
+  /// Updates a handle has to be found masked by before its subscription
+  /// switches to the masked QoS:
+  static constexpr int MASKED_UPDATES = 2;
+
+  std::string type_;
+
+  /// Last message, and the command referring to it:
+  std::shared_ptr<const void> message_;
+  VelocityCommand command_;
+
+  /// Subscription of the input type of the handle, with a given QoS:
+  std::function<void(const rclcpp::QoS &)> subscribe_;
+  std::optional<rclcpp::QoS> masked_qos_;
+  int masked_updates_;
+  bool masked_subscription_;
+};
 
+class LockTopicHandle : public TopicHandle
+{
+public:
   LockTopicHandle(
     const std::string & name, const std::string & topic, const rclcpp::Duration & timeout,
-    priority_type priority, TwistMux * mux)
-  : base_type(name, topic, timeout, priority, mux)
+    priority_type priority, TwistMux * mux, const rclcpp::QoS & qos = rclcpp::SystemDefaultsQoS())
+  : TopicHandle(name, topic, timeout, priority, mux, qos)
   {
-    subscriber_ = mux_->template create_subscription<std_msgs::msg::Bool>(
-      topic_, rclcpp::SystemDefaultsQoS(),
-      std::bind(&LockTopicHandle::callback, this, std::placeholders::_1));
+    {
+      std::lock_guard<std::mutex> lock(mux_->getArbitrationMutex());
+      id_ = mux_->getArbitration().addLock(priority_, timeout_.nanoseconds());
+    }
+
+    subscribe<std_msgs::msg::Bool>(
+      std::bind(&LockTopicHandle::callback, this, std::placeholders::_1), qos_);
   }
 
   /**
@@ -224,13 +610,23 @@ public:
    */
   bool isLocked() const
   {
-    return hasExpired() || getMessage().data;
+    return mux_->getArbitration().isLocked(id_);
   }
 
   void callback(const std_msgs::msg::Bool::ConstSharedPtr msg)
   {
-    stamp_ = mux_->now();
-    msg_ = *msg;
+    {
+      std::lock_guard<std::mutex> lock(mux_->getArbitrationMutex());
+
+      stamp_ = mux_->now();
+
+      mux_->getArbitration().lockReceived(id_, msg->data, stamp_.nanoseconds());
+      mux_->updateLock();
+      mux_->updateActiveSource();
+
+      received();
+    }
+    mux_->flushOutput();
   }
 };
 
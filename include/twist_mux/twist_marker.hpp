@@ -0,0 +1,280 @@
+// Copyright 2020 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/*
+ * @author Enrique Fernandez
+ * @author Jeremie Deray
+ * @author Brighten Lee
+ */
+
+#ifndef TWIST_MUX__TWIST_MARKER_HPP_
+#define TWIST_MUX__TWIST_MARKER_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+#include <geometry_msgs/msg/twist.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include <visualization_msgs/msg/marker.hpp>
+#include <visualization_msgs/msg/marker_array.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace twist_mux
+{
+class TwistMarker
+{
+public:
+  /**
+   * @param id Id of the marker, and namespace 'ns' of its topic when there
+   * are several
+   */
+  TwistMarker(
+    std::string & frame_id, double scale, double z, int id = 0,
+    const std::string & ns = std::string())
+  : frame_id_(frame_id), scale_(scale), z_(z), published_x_(0.0), published_y_(0.0),
+    published_(false)
+  {
+    // ID and type:
+    marker_.ns = ns;
+    marker_.id = id;
+    marker_.type = visualization_msgs::msg::Marker::ARROW;
+
+    // Frame ID:
+    marker_.header.frame_id = frame_id_;
+
+    // Pre-allocate points for setting the arrow with the twist:
+    marker_.points.resize(2);
+
+    // Vertical position:
+    marker_.pose.position.z = z_;
+
+    // Scale:
+    marker_.scale.x = 0.05 * scale_;
+    marker_.scale.y = 2 * marker_.scale.x;
+
+    // Color:
+    marker_.color.a = 1.0;
+    marker_.color.r = 0.0;
+    marker_.color.g = 1.0;
+    marker_.color.b = 0.0;
+
+    // Error when all points are zero:
+    marker_.points[1].z = 0.01;
+  }
+
+  void update(const geometry_msgs::msg::Twist & twist)
+  {
+    using std::abs;
+
+    marker_.points[1].x = twist.linear.x;
+
+    if (abs(twist.linear.y) > abs(twist.angular.z)) {
+      marker_.points[1].y = twist.linear.y;
+    } else {
+      marker_.points[1].y = twist.angular.z;
+    }
+  }
+
+  /**
+   * @brief hasChanged
+   * @param tolerance Distance in [m] the tip of the arrow must have moved,
+   * negative to take every arrow as changed
+   * @return true if the arrow has never been published, or has moved more
+   * than 'tolerance' since it was
+   */
+  bool hasChanged(double tolerance) const
+  {
+    using std::abs;
+
+    return tolerance < 0.0 || !published_ ||
+           abs(marker_.points[1].x - published_x_) > tolerance ||
+           abs(marker_.points[1].y - published_y_) > tolerance;
+  }
+
+  /**
+   * @brief setPublished Takes the current arrow as the one published
+   */
+  void setPublished()
+  {
+    published_x_ = marker_.points[1].x;
+    published_y_ = marker_.points[1].y;
+    published_ = true;
+  }
+
+  const visualization_msgs::msg::Marker & getMarker()
+  {
+    return marker_;
+  }
+
+private:
+  visualization_msgs::msg::Marker marker_;
+
+  std::string frame_id_;
+  double scale_;
+  double z_;
+
+  /// Tip of the arrow last published:
+  double published_x_;
+  double published_y_;
+  bool published_;
+};
+
+/**
+ * @brief The TwistMarkerPublisher class shows twists as arrows in RViz.
+ *
+ * With a single topic ('twist', the default) it publishes a Marker on
+ * 'marker'; with a list of topics it publishes the arrows of all of them in
+ * a single MarkerArray on 'markers', stacked vertically in their order.
+ *
+ * The arrows are published on each message, or at the display rate when
+ * it is set, so an RViz started late still gets them. With a tolerance,
+ * which is opt-in, an arrow is only published once it moved more than the
+ * tolerance; a MarkerArray then only carries the arrows that moved, as RViz
+ * keeps the others.
+ */
+class TwistMarkerPublisher : public rclcpp::Node
+{
+public:
+  explicit TwistMarkerPublisher(const rclcpp::NodeOptions & options = rclcpp::NodeOptions())
+  : Node("twist_marker", options)
+  {
+    std::string frame_id;
+    double scale;
+    bool use_stamped;
+    double z;
+    std::vector<std::string> topics;
+    double rate;
+
+    this->declare_parameter("frame_id", "base_footprint");
+    this->declare_parameter("scale", 1.0);
+    this->declare_parameter("use_stamped", false);
+    this->declare_parameter("vertical_position", 2.0);
+    this->declare_parameter("topics", std::vector<std::string>());
+    this->declare_parameter("rate", 0.0);
+    this->declare_parameter("tolerance", -1.0);
+
+    this->get_parameter<std::string>("frame_id", frame_id);
+    this->get_parameter<double>("scale", scale);
+    this->get_parameter<bool>("use_stamped", use_stamped);
+    this->get_parameter<double>("vertical_position", z);
+    this->get_parameter<std::vector<std::string>>("topics", topics);
+    this->get_parameter<double>("rate", rate);
+    this->get_parameter<double>("tolerance", tolerance_);
+
+    if (topics.empty()) {
+      markers_.emplace_back(frame_id, scale, z);
+      pub_ = this->create_publisher<visualization_msgs::msg::Marker>(
+        "marker", rclcpp::QoS(rclcpp::KeepLast(1)));
+      topics.push_back("twist");
+    } else {
+      for (std::size_t i = 0; i < topics.size(); ++i) {
+        markers_.emplace_back(
+          frame_id, scale, z + static_cast<double>(i) * scale, static_cast<int>(i), topics[i]);
+      }
+      array_pub_ = this->create_publisher<visualization_msgs::msg::MarkerArray>(
+        "markers", rclcpp::QoS(rclcpp::KeepLast(1)));
+      array_.markers.reserve(markers_.size());
+    }
+
+    for (std::size_t i = 0; i < topics.size(); ++i) {
+      if (use_stamped) {
+        subs_.push_back(
+          this->create_subscription<geometry_msgs::msg::TwistStamped>(
+            topics[i], rclcpp::SystemDefaultsQoS(),
+            [this, i](const geometry_msgs::msg::TwistStamped::ConstSharedPtr twist) {
+              callback(i, twist->twist);
+            }));
+      } else {
+        subs_.push_back(
+          this->create_subscription<geometry_msgs::msg::Twist>(
+            topics[i], rclcpp::SystemDefaultsQoS(),
+            [this, i](const geometry_msgs::msg::Twist::ConstSharedPtr twist) {
+              callback(i, *twist);
+            }));
+      }
+    }
+
+    if (rate > 0.0) {
+      timer_ = this->create_wall_timer(
+        std::chrono::duration<double>(1.0 / rate), [this]() -> void {publish();});
+    }
+  }
+
+  void callback(std::size_t index, const geometry_msgs::msg::Twist & twist)
+  {
+    markers_[index].update(twist);
+
+    // Otherwise the timer publishes at the display rate:
+    if (!timer_) {
+      publish();
+    }
+  }
+
+  /**
+   * @brief publish Publishes the arrows, or only those that moved more than
+   * the tolerance when it is set
+   */
+  void publish()
+  {
+    if (pub_) {
+      auto & marker = markers_.front();
+      if (marker.hasChanged(tolerance_)) {
+        pub_->publish(marker.getMarker());
+        marker.setPublished();
+      }
+      return;
+    }
+
+    array_.markers.clear();
+    for (auto & marker : markers_) {
+      if (marker.hasChanged(tolerance_)) {
+        array_.markers.push_back(marker.getMarker());
+        marker.setPublished();
+      }
+    }
+    if (!array_.markers.empty()) {
+      array_pub_->publish(array_);
+    }
+  }
+
+private:
+  std::vector<rclcpp::SubscriptionBase::SharedPtr> subs_;
+  rclcpp::Publisher<visualization_msgs::msg::Marker>::SharedPtr pub_;
+  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr array_pub_;
+  rclcpp::TimerBase::SharedPtr timer_;
+
+  std::vector<TwistMarker> markers_;
+  visualization_msgs::msg::MarkerArray array_;
+  double tolerance_ = -1.0;
+};
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__TWIST_MARKER_HPP_
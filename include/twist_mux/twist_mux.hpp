@@ -39,21 +39,40 @@
 #include <std_msgs/msg/bool.hpp>
 #include <geometry_msgs/msg/twist.hpp>
 #include <geometry_msgs/msg/twist_stamped.hpp>
+#include <twist_mux/msg/active_source.hpp>
+#include <twist_mux/msg/twist_mux_sources.hpp>
+#include <twist_mux/msg/twist_mux_statistics.hpp>
 
-#include <list>
+#include <twist_mux/arbitration_engine.hpp>
+#include <twist_mux/event_recorder.hpp>
+#include <twist_mux/latency_histogram.hpp>
+#include <twist_mux/status_mirror.hpp>
+#include <twist_mux/velocity_input.hpp>
+
+#include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <vector>
 
 using std::chrono_literals::operator""s;
 
+namespace diagnostic_updater
+{
+class Updater;
+}  // namespace diagnostic_updater
+
 namespace twist_mux
 {
 // Forwarding declarations:
 class TwistMuxDiagnostics;
 struct TwistMuxDiagnosticsStatus;
-template <typename T>
 class VelocityTopicHandle;
 class LockTopicHandle;
+class TwistOutputBase;
+class VelocityLimiter;
 
 /**
  * @brief The TwistMux class implements a top-level twist multiplexer module
@@ -63,57 +82,568 @@ class TwistMux : public rclcpp::Node
 {
 public:
   template<typename T>
-  using handle_container = std::list<T>;
-  using velocity_handle_variant = std::variant<VelocityTopicHandle<geometry_msgs::msg::Twist>, VelocityTopicHandle<geometry_msgs::msg::TwistStamped>>;
-  using publisher_variant = std::variant<rclcpp::Publisher<geometry_msgs::msg::Twist>::SharedPtr, rclcpp::Publisher<geometry_msgs::msg::TwistStamped>::SharedPtr>;
-  using message_variant = std::variant<geometry_msgs::msg::Twist, geometry_msgs::msg::TwistStamped>;
-
-  using velocity_topic_container = handle_container<velocity_handle_variant>;
+  using handle_container = std::deque<std::shared_ptr<T>>;
+  using velocity_topic_container = handle_container<VelocityTopicHandle>;
   using lock_topic_container = handle_container<LockTopicHandle>;
 
-  TwistMux();
-  ~TwistMux() = default;
+  static constexpr std::chrono::duration<int64_t> DIAGNOSTICS_PERIOD = 1s;
 
-  void init();
+  /**
+   * @brief EXPIRY_CHECK_PERIOD Period of the check of the handle deadlines;
+   * handles expire at most this late when no message is received.
+   */
+  static constexpr std::chrono::milliseconds EXPIRY_CHECK_PERIOD = std::chrono::milliseconds(10);
+
+  /**
+   * @brief The TopicConfig struct holds the parameters of a velocity or lock
+   * handle
+   */
+  struct TopicConfig
+  {
+    std::string name;
+    std::string topic;
+    double timeout;
+    int priority;
+    /// Input type of a velocity handle, as in VelocityInputTraits:
+    std::string type;
+    std::string group;
+    rclcpp::QoS qos;
+    /// QoS of a velocity handle while it stays masked, if any:
+    std::optional<rclcpp::QoS> masked_qos;
+  };
+
+  /**
+   * @brief The GroupConfig struct holds the parameters of a group of
+   * velocity handles
+   */
+  struct GroupConfig
+  {
+    int priority;
+    bool own_thread;
+  };
+
+  typedef std::map<std::string, GroupConfig> group_config_map;
+
+  /**
+   * @brief The Configuration struct holds the groups, the velocity handles
+   * and the lock handles of a mux
+   */
+  struct Configuration
+  {
+    group_config_map groups;
+    std::vector<TopicConfig> velocities;
+    std::vector<TopicConfig> locks;
+  };
+
+  /**
+   * @brief TwistMux
+   * @param options Node options; parameters are always allowed to be
+   * undeclared and declared from overrides, since the topics and locks
+   * are read from an arbitrary parameter tree
+   */
+  explicit TwistMux(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+  /**
+   * @brief TwistMux Creates a mux with a configuration compiled in, e.g. by
+   * the executable of a robot, instead of the 'groups', 'topics' and 'locks'
+   * parameters, which then cannot reconfigure it; the other settings are
+   * still read from the parameters
+   * @param configuration Configuration, which should have passed validate()
+   * in the tests of that executable
+   * @throw ParamsHelperException if the configuration is invalid
+   */
+  TwistMux(const Configuration & configuration, const rclcpp::NodeOptions & options);
+
+  /**
+   * @brief TwistMux Creates a mux hosted with others in a process, which
+   * has neither an expiry nor a diagnostics timer: the host runs
+   * checkExpiry() every EXPIRY_CHECK_PERIOD and updateDiagnostics() every
+   * DIAGNOSTICS_PERIOD for all its muxes, from a single timer each
+   * @param diagnostics Updater of the host, which reports the status of
+   * each mux as a task of its own
+   */
+  TwistMux(
+    const rclcpp::NodeOptions & options,
+    std::shared_ptr<diagnostic_updater::Updater> diagnostics);
+  ~TwistMux();
+
+  /**
+   * @brief validate Checks a configuration as the parameters are checked
+   * @throw ParamsHelperException for the first invalid group or handle
+   */
+  static void validate(const Configuration & configuration);
 
-  template <typename VelocityTopicHandleT>
-  bool hasPriority(const VelocityTopicHandleT & twist);
+  /**
+   * @brief hasPriority Updates the arbitration with the last message received
+   * by a velocity handle
+   * @param twist Velocity handle
+   * @return true if the handle is the current winner
+   */
+  bool hasPriority(const VelocityTopicHandle & twist);
 
-  
-  template <typename MessageConstSharedPtrT>
-  void publishTwist(const MessageConstSharedPtrT & msg);
+  /**
+   * @brief publishTwist Publishes a command of the winner, unless the output
+   * runs at a fixed rate, in which case the timer samples the winner
+   * @param command Command, converted into the message published
+   * @param stop true for the fail-safe twist, which the smoothing does not
+   * slow down
+   */
+  void publishTwist(const VelocityCommand & command, bool stop = false);
 
+  /**
+   * @brief flushOutput Publishes the command staged on the output, if any;
+   * called without the arbitration mutex, after each operation that holds it
+   * and might have staged a command
+   */
+  void flushOutput();
+
+  /**
+   * @brief checkExpiry Expires the handles whose deadline has passed, and
+   * publishes a command held back by the rate limit or the smoothing
+   */
+  void checkExpiry();
+
+  /**
+   * @brief updateDiagnostics Takes a new status of the mux for the
+   * diagnostics, and switches the subscriptions of the masked handles
+   */
   void updateDiagnostics();
 
+  ArbitrationEngine & getArbitration()
+  {
+    return arbitration_;
+  }
+
+  /**
+   * @brief getArbitrationMutex Mutex that guards the arbitration state and
+   * the last message of the handles, held for the few operations of each
+   * command callback; the output is only staged under it, and published by
+   * flushOutput() once it is released
+   */
+  std::mutex & getArbitrationMutex()
+  {
+    return arbitration_mutex_;
+  }
+
+  /**
+   * @brief getCallbackLatency Duration of the velocity callbacks, from the
+   * reception of the message to the end of the publish
+   */
+  LatencyHistogram & getCallbackLatency()
+  {
+    return callback_latency_;
+  }
+
+  /**
+   * @brief getCommandCallbackGroup
+   * @return Reentrant callback group of the velocity and lock subscriptions
+   * and the expiry timer in multi-threaded mode, or nullptr (the default
+   * callback group of the node) otherwise
+   */
+  rclcpp::CallbackGroup::SharedPtr getCommandCallbackGroup() const
+  {
+    return command_group_;
+  }
+
+  /**
+   * @brief expire Expires a handle on an event of its subscription
+   * @param id Arbitration id of the handle
+   */
+  void expire(ArbitrationEngine::handle_id id);
+
+  /**
+   * @brief updateActiveSource Publishes ~/active_source if the winner or the
+   * lock priority changed; called with the arbitration mutex held after
+   * each operation on the arbitration, a few compares when nothing changed
+   */
+  void updateActiveSource();
+
+  /**
+   * @brief updateLock Re-arbitrates the output when the lock priority
+   * changed, instead of waiting for the next velocity message: a lock that
+   * masks the winner publishes a stop at once, and the output switches to
+   * the new winner when a lock releases; called with the arbitration mutex
+   * held, a compare when nothing changed
+   */
+  void updateLock();
+
+  /**
+   * @brief getCallbackGroup
+   * @return Callback group of the subscriptions of a group of velocity
+   * handles: its own one if the group has its own thread, the command
+   * callback group otherwise (and for NO_GROUP)
+   */
+  rclcpp::CallbackGroup::SharedPtr getCallbackGroup(ArbitrationEngine::group_id group) const
+  {
+    if (group < group_callback_groups_.size() && group_callback_groups_[group]) {
+      return group_callback_groups_[group];
+    }
+    return command_group_;
+  }
+
+  /**
+   * @brief getGroupCallbackGroups
+   * @return Callback group of each group of velocity handles, nullptr for
+   * the groups without their own thread
+   */
+  const std::vector<rclcpp::CallbackGroup::SharedPtr> & getGroupCallbackGroups() const
+  {
+    return group_callback_groups_;
+  }
+
+  /**
+   * @brief getCommandThreads
+   * @return Number of threads for the command callback group,
+   *         0 meaning one per core
+   */
+  std::size_t getCommandThreads() const
+  {
+    return command_threads_;
+  }
+
+  /**
+   * @brief getMessagePoolSize
+   * @return Number of messages preallocated for each subscription,
+   *         0 if the memory pool is disabled
+   */
+  std::size_t getMessagePoolSize() const
+  {
+    return message_pool_size_;
+  }
+
 protected:
+  void init();
+
+  /**
+   * @brief readConfiguration Reads the groups, the velocity and the lock
+   * handles from the parameters
+   * @throw ParamsHelperException if a group or a handle is invalid
+   */
+  Configuration readConfiguration();
+
+  /**
+   * @brief validateTopic Checks the type and the group of a velocity handle
+   * @throw ParamsHelperException if either is unknown
+   */
+  static void validateTopic(const TopicConfig & config, const group_config_map & groups);
+
+  /**
+   * @brief TwistMux Reads the configuration from the parameters, unless one
+   * is compiled in
+   */
+  TwistMux(
+    std::optional<Configuration> configuration, const rclcpp::NodeOptions & options,
+    std::shared_ptr<diagnostic_updater::Updater> diagnostics);
+
+  /// Configuration compiled in, if any, which the parameters do not change:
+  std::optional<Configuration> compiled_configuration_;
+
   typedef TwistMuxDiagnostics diagnostics_type;
   typedef TwistMuxDiagnosticsStatus status_type;
 
+  /// Timers of a mux that is not hosted; the host runs checkExpiry() and
+  /// updateDiagnostics() otherwise:
   rclcpp::TimerBase::SharedPtr diagnostics_timer_;
+  rclcpp::TimerBase::SharedPtr expiry_timer_;
 
-  static constexpr std::chrono::duration<int64_t> DIAGNOSTICS_PERIOD = 1s;
+  /// Diagnostics updater of the host, if any:
+  std::shared_ptr<diagnostic_updater::Updater> host_diagnostics_;
+
+  /// Held by reconfigure() and updateDiagnostics(), which a host runs from
+  /// another callback group than the one of the reconfiguration:
+  std::mutex reconfigure_mutex_;
 
   /**
    * @brief velocity_hs_ Velocity topics' handles.
-   * Note that if we use a vector, as a consequence of the re-allocation and
-   * the fact that we have a subscriber inside with a pointer to 'this', we
-   * must reserve the number of handles initially.
+   * The handles are shared, as they have a subscriber inside with a pointer
+   * to 'this', so a reconfiguration builds new containers with the handles
+   * it keeps, and swaps them in; the diagnostics keep reading the previous
+   * containers until their next update.
+   * The handles only hold cold data (names, topics, subscriptions, last
+   * message); the state read on every message lives in arbitration_.
    */
   std::shared_ptr<velocity_topic_container> velocity_hs_;
   std::shared_ptr<lock_topic_container> lock_hs_;
 
-  publisher_variant cmd_pub_;
-  message_variant last_cmd_;
+  /**
+   * @brief arbitration_ Arbitration state of the handles above, which keeps
+   * the current winner cached.
+   */
+  ArbitrationEngine arbitration_;
+  std::mutex arbitration_mutex_;
+
+  /// Trace of the arbitration, written under the mutex above:
+  std::unique_ptr<EventRecorder> recorder_;
+
+  /// Shared-memory mirror of the state, also written under the mutex:
+  std::unique_ptr<StatusMirror> status_mirror_;
+  StatusMirror::Status mirror_status_;
+  ArbitrationEngine::handle_id mirror_winner_;
+
+  LatencyHistogram callback_latency_;
+
+  /// Multi-threaded mode:
+  rclcpp::CallbackGroup::SharedPtr command_group_;
+  std::size_t command_threads_;
+
+  /// Groups of velocity handles, by name, and their callback groups when
+  /// they have their own thread:
+  std::map<std::string, ArbitrationEngine::group_id> group_ids_;
+  std::vector<rclcpp::CallbackGroup::SharedPtr> group_callback_groups_;
+
+  /// Memory pool, to forward commands without allocating:
+  std::size_t message_pool_size_;
+
+  /**
+   * @brief output_ Output stage, resolved in init() to the output message type.
+   */
+  std::unique_ptr<TwistOutputBase> output_;
+
+  /// Twist of the last command published, kept when the deduplication or
+  /// the smoothing needs it:
+  geometry_msgs::msg::Twist last_twist_;
+
+  /**
+   * @brief Output scheduling: publish the winner at a fixed rate instead of
+   * on each of its messages, limit the rate of the publishes, and skip
+   * commands identical to the last published one.
+   * A command held back by the rate limit is published by the expiry timer
+   * as soon as the rate allows it, so the last command is never lost.
+   */
+  rclcpp::TimerBase::SharedPtr output_timer_;
+  std::chrono::nanoseconds min_output_interval_;
+  bool fixed_rate_output_;
+  bool deduplicate_output_;
+  bool output_pending_;
+  bool has_output_;
+  std::chrono::steady_clock::time_point last_output_time_;
+
+  /**
+   * @brief Output smoothing: acceleration and jerk limits, and only allow
+   * the command to decrease for some time after the lock priority changes.
+   * A command limited by the smoothing is kept pending, so the output keeps
+   * ramping towards it.
+   */
+  std::unique_ptr<VelocityLimiter> limiter_;
+  std::chrono::nanoseconds lock_transition_time_;
+  std::chrono::steady_clock::time_point lock_transition_end_;
+  ArbitrationEngine::priority_type last_lock_priority_;
 
   bool output_stamped;
 
-  template<typename T>
-  void getTopicHandles(const std::string & param_name, handle_container<T> & topic_hs);
+  /**
+   * @brief failsafe_enabled_ Publish on expiry of the active source instead of
+   * letting the output go silent.
+   */
+  bool failsafe_enabled_;
+  geometry_msgs::msg::TwistStamped failsafe_cmd_;
+  VelocityCommand failsafe_command_;
+
+  /// Source whose command was published last, NO_HANDLE after a fail-safe:
+  ArbitrationEngine::handle_id active_;
+
+  /// Time from the deadline of the previous source to its handover, last
+  /// and maximum in [s], copied to the diagnostics under the mutex:
+  double handover_latency_;
+  double max_handover_latency_;
+
+  /// Lock priority the output was arbitrated with, and the command published
+  /// when a lock masks every source:
+  ArbitrationEngine::priority_type output_lock_priority_;
+  geometry_msgs::msg::TwistStamped stop_cmd_;
+  VelocityCommand stop_command_;
+
+  /// Velocity handles by arbitration id:
+  std::vector<VelocityTopicHandle *> velocity_by_id_;
+
+  /**
+   * @brief Reconfiguration: a change of the 'topics', 'locks' or 'groups'
+   * parameters is applied after RECONFIGURE_DELAY, so the parameters of a
+   * new handle set one by one are applied at once.
+   * The handles removed by a reconfiguration are kept until the next one,
+   * as callbacks taken before their removal might still run.
+   */
+  static constexpr std::chrono::milliseconds RECONFIGURE_DELAY = std::chrono::milliseconds(100);
+
+  rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr parameters_callback_;
+  rclcpp::TimerBase::SharedPtr reconfigure_timer_;
+  velocity_topic_container retired_velocity_hs_;
+  lock_topic_container retired_lock_hs_;
+
+  /**
+   * @brief Readiness: ~/ready (transient local) is false until all the
+   * handles have matched a publisher, so whatever waits on the mux knows
+   * when the commands flow end to end.
+   */
+  static constexpr std::chrono::milliseconds READY_CHECK_PERIOD = std::chrono::milliseconds(20);
+
+  rclcpp::Publisher<std_msgs::msg::Bool>::SharedPtr ready_pub_;
+  rclcpp::TimerBase::SharedPtr ready_timer_;
+  bool ready_;
+  std::chrono::steady_clock::time_point start_time_;
+
+  void initReady();
+
+  /**
+   * @brief updateReady Publishes the readiness once all the handles are
+   * matched, and stops checking
+   */
+  void updateReady();
+
+  /**
+   * @brief Active source: ~/active_source (transient local) carries the
+   * winner and the lock priority, and is only published when they change,
+   * so nothing needs to poll the diagnostics to know who drives.
+   */
+  rclcpp::Publisher<msg::ActiveSource>::SharedPtr active_source_pub_;
+  msg::ActiveSource active_source_msg_;
+  ArbitrationEngine::handle_id active_source_winner_;
+  /// Lock priority published, or -1 to publish on the next update:
+  ArbitrationEngine::priority_type active_source_lock_priority_;
+
+  /**
+   * @brief readGroups Reads the groups of velocity handles
+   * @throw ParamsHelperException if a group is invalid
+   */
+  group_config_map readGroups(const std::string & param_name);
+
+  /**
+   * @brief readTopics Reads the velocity or lock handles
+   * @param groups Groups the velocity handles might belong to
+   * @throw ParamsHelperException if a handle is invalid
+   */
+  std::vector<TopicConfig> readTopics(
+    const std::string & param_name, bool velocity,
+    const group_config_map & groups);
+
+  /**
+   * @brief addGroup Registers a group of velocity handles, with its own
+   * callback group if it has its own thread
+   */
+  void addGroup(const std::string & name, const GroupConfig & config, bool own_thread);
+
+  /**
+   * @brief createVelocityHandle Creates a handle of the input type of the
+   * configuration, among the types of velocityInputs()
+   */
+  std::shared_ptr<VelocityTopicHandle> createVelocityHandle(const TopicConfig & config);
+
+  std::shared_ptr<LockTopicHandle> createLockHandle(const TopicConfig & config);
+
+  /**
+   * @brief indexVelocities Builds the index of velocity handles by id
+   */
+  static std::vector<VelocityTopicHandle *> indexVelocities(
+    const velocity_topic_container & velocity_hs);
+
+  /**
+   * @brief getVelocityHandle
+   * @return Velocity handle of an arbitration id, nullptr while a handle
+   * added by a reconfiguration is not swapped in yet
+   */
+  VelocityTopicHandle * getVelocityHandle(ArbitrationEngine::handle_id id) const
+  {
+    return (id < velocity_by_id_.size()) ? velocity_by_id_[id] : nullptr;
+  }
+
+  /**
+   * @brief reconfigure Applies the current 'topics', 'locks' and 'groups'
+   * parameters: the handles whose topic, type or group are unchanged are
+   * kept, with their subscription and state, and only get their priority
+   * and timeout updated; an invalid configuration changes nothing.
+   * The new handles subscribe, and the new containers are built, before the
+   * arbitration mutex is taken, which is then only held to update the
+   * engine and swap the containers in
+   */
+  void reconfigure();
 
   int getLockPriority();
 
+  /**
+   * @brief updateMirror Writes the winner, the lock priority and the last
+   * output to the status mirror, if any; on each output and from the expiry
+   * timer, whose period is then the heartbeat of the mux
+   */
+  void updateMirror();
+
+  /**
+   * @brief updateExpiry Samples the clock and expires the handles whose
+   * deadline has passed
+   */
+  void updateExpiry();
+
+  /**
+   * @brief handover When the fail-safe mode is enabled and the active source
+   * has expired, publishes the last message of the new winner, or the
+   * fail-safe twist if there is none.
+   * @param stamp Current time [ns]
+   */
+  void handover(ArbitrationEngine::time_type stamp);
+
+  /**
+   * @brief publishWinner Publishes the last message of the winner, or the
+   * fail-safe twist when enabled and there is no winner
+   */
+  void publishWinner();
+
+  /**
+   * @brief publishOutput Publishes on the output, applying the rate limit,
+   * the smoothing and the deduplication
+   * @param stop true for the fail-safe twist, as for publishTwist()
+   */
+  void publishOutput(const VelocityCommand & command, bool stop = false);
+
+  /**
+   * @brief emitOutput Converts a command into the output, smooths and
+   * deduplicates it in place, and stages it
+   * @param smoothing false for a command the smoothing must not limit
+   */
+  void emitOutput(
+    const VelocityCommand & command, bool stop,
+    std::chrono::steady_clock::time_point now, bool smoothing = true);
+
+  /**
+   * @brief smooth Applies the smoothing to a command; a stop, or any command
+   * during a lock transition, slows down without limit
+   * @return true if the command has been limited
+   */
+  bool smooth(
+    geometry_msgs::msg::Twist & twist, std::chrono::steady_clock::time_point now, bool stop);
+
+  const geometry_msgs::msg::Twist & getLastTwist() const;
+
+  /**
+   * @brief updateStatistics Collects the hot path statistics recorded since
+   * the last diagnostics update
+   */
+  void updateStatistics();
+
   std::shared_ptr<diagnostics_type> diagnostics_;
   std::shared_ptr<status_type> status_;
+
+  /**
+   * @brief statistics_msg_ Statistics of the sources, published by reference
+   * at a fixed rate on ~/statistics; the names of the sources are published
+   * once on ~/statistics/sources.
+   */
+  rclcpp::TimerBase::SharedPtr statistics_timer_;
+  rclcpp::Publisher<msg::TwistMuxStatistics>::SharedPtr statistics_pub_;
+  rclcpp::Publisher<msg::TwistMuxSources>::SharedPtr sources_pub_;
+  msg::TwistMuxStatistics statistics_msg_;
+
+  void initStatistics(double rate);
+
+  /**
+   * @brief publishSources Publishes the names of the sources, in the order
+   * of the statistics
+   */
+  void publishSources();
+
+  /**
+   * @brief publishStatistics Copies the counters kept by the callbacks and
+   * the arbitration engine into the statistics message
+   */
+  void publishStatistics();
 };
 
 }  // namespace twist_mux
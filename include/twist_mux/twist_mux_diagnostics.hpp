@@ -40,9 +40,20 @@
 #include <diagnostic_updater/diagnostic_updater.hpp>
 
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace twist_mux
 {
+/**
+ * @brief The TwistMuxDiagnostics class reports the status of the mux on
+ * /diagnostics, at the rate of the diagnostic updater.
+ *
+ * The values are kept formatted between two updates, and the value of a
+ * handle is only formatted again when what it reports has changed; the
+ * updater then publishes the cached values without formatting anything.
+ */
 class TwistMuxDiagnostics
 {
 public:
@@ -51,13 +62,21 @@ public:
   static constexpr double MAIN_LOOP_TIME_MIN = 0.2;   // [s]
   static constexpr double READING_AGE_MIN = 3.0;     // [s]
 
-  explicit TwistMuxDiagnostics(TwistMux * mux);
-  virtual ~TwistMuxDiagnostics() = default;
+  /**
+   * @param updater Updater shared by the muxes of a process, which then
+   * reports each of them as a task of its own; by default the mux has its
+   * own updater
+   */
+  explicit TwistMuxDiagnostics(
+    TwistMux * mux, std::shared_ptr<diagnostic_updater::Updater> updater = nullptr);
+  virtual ~TwistMuxDiagnostics();
 
   void diagnostics(diagnostic_updater::DiagnosticStatusWrapper & stat);
 
-  void update();
-
+  /**
+   * @brief updateStatus Takes a new status of the mux, which the updater
+   * publishes on its next run
+   */
   void updateStatus(const status_type::ConstPtr & status);
 
 private:
@@ -71,8 +90,54 @@ private:
     ERROR = diagnostic_msgs::msg::DiagnosticStatus::ERROR
   };
 
+  /**
+   * @brief The HandleState struct holds what the value of a handle reports,
+   * to only format it again when it changes; the statistics, which vary
+   * on every update, are held at the precision they are displayed with, so
+   * they only count as a change when the text would change
+   */
+  struct HandleState
+  {
+    bool masked;
+    int priority;
+    double timeout;
+    /// Rate in [0.1 Hz], and age in [us]:
+    long long rate;
+    long long age;
+
+    bool operator==(const HandleState & other) const
+    {
+      return masked == other.masked && priority == other.priority &&
+             timeout == other.timeout && rate == other.rate && age == other.age;
+    }
+  };
+
+  /**
+   * @brief updateKeys Builds the diagnostics key of each handle, and resets
+   * the values
+   */
+  void updateKeys(const status_type & status);
+
+  /**
+   * @brief updateValues Formats the values that changed since the last status
+   */
+  void updateValues();
+
   std::shared_ptr<diagnostic_updater::Updater> diagnostic_;
+  /// Name of the task of the mux, removed from a shared updater with it:
+  std::string name_;
   std::shared_ptr<status_type> status_;
+
+  /// The updater runs diagnostics() from its own timer while updateStatus()
+  /// is called:
+  std::mutex status_mutex_;
+
+  /// Values published, the handles first, in the order of the containers,
+  /// then the values of the mux:
+  std::vector<diagnostic_msgs::msg::KeyValue> values_;
+
+  /// State reported by the value of each handle:
+  std::vector<HandleState> states_;
 };
 }  // namespace twist_mux
 
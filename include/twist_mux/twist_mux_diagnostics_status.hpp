@@ -37,10 +37,13 @@
 
 #include <twist_mux/twist_mux.hpp>
 #include <twist_mux/topic_handle.hpp>
+#include <twist_mux/latency_histogram.hpp>
 
 #include <rclcpp/rclcpp.hpp>
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace twist_mux
 {
@@ -49,12 +52,42 @@ struct TwistMuxDiagnosticsStatus
   typedef std::shared_ptr<TwistMuxDiagnosticsStatus> Ptr;
   typedef std::shared_ptr<const TwistMuxDiagnosticsStatus> ConstPtr;
 
+  /**
+   * @brief The SourceStatistics struct holds the statistics of a handle
+   * over the last diagnostics period
+   */
+  struct SourceStatistics
+  {
+    std::uint64_t received = 0;  ///< Messages received since the start
+    double rate = 0;             ///< Receive rate in [Hz]
+    double age = 0;              ///< Worst age of the stamped messages in [s]
+  };
+
+  /// Worst age of the stamped messages, and worst duration of the velocity
+  /// callbacks, over the last diagnostics period in [s]:
   double reading_age;
   rclcpp::Time last_loop_update;
   double main_loop_time;
 
+  /// Duration of the velocity callbacks over the last diagnostics period:
+  LatencyHistogram::Snapshot callback_latency;
+
+  std::uint64_t winner_switches;
+
+  /// Statistics of the handles, in the order of the containers:
+  std::vector<SourceStatistics> velocity_statistics;
+  std::vector<SourceStatistics> lock_statistics;
+
+  /// Time between the deadline of the active source and the fail-safe
+  /// handover, last and worst:
+  double handover_latency;
+  double max_handover_latency;
+
   LockTopicHandle::priority_type priority;
 
+  /// Copy of the arbitration state, to report the state of the handles:
+  ArbitrationEngine arbitration;
+
   std::shared_ptr<TwistMux::velocity_topic_container> velocity_hs;
   std::shared_ptr<TwistMux::lock_topic_container> lock_hs;
 
@@ -62,6 +95,9 @@ struct TwistMuxDiagnosticsStatus
   : reading_age(0),
     last_loop_update(rclcpp::Clock().now()),
     main_loop_time(0),
+    winner_switches(0),
+    handover_latency(0),
+    max_handover_latency(0),
     priority(0)
   {
     velocity_hs = std::make_shared<TwistMux::velocity_topic_container>();
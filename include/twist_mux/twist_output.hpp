@@ -0,0 +1,227 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__TWIST_OUTPUT_HPP_
+#define TWIST_MUX__TWIST_OUTPUT_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+#include <geometry_msgs/msg/twist.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+
+#include <twist_mux/velocity_input.hpp>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace twist_mux
+{
+/**
+ * @brief The TwistOutputBase class is the output stage of the mux, which
+ * publishes the commands of the handles, whatever their input type, on the
+ * output topic.
+ *
+ * A command is published in three steps: prepare() converts it into the
+ * next message to publish, whose twist the mux then limits and compares in
+ * place; stage() makes that message the one to publish; and flush()
+ * publishes it. prepare() and stage() are called by a single writer, the
+ * holder of the arbitration mutex, and flush() from any thread once it is
+ * released, so a callback does not block the others for the time of a
+ * publish. A message staged over another before it is flushed supersedes
+ * it, and a prepared message which is not staged is prepared again by the
+ * next prepare().
+ */
+class TwistOutputBase
+{
+public:
+  virtual ~TwistOutputBase() = default;
+
+  /**
+   * @brief prepare Converts 'command' into the next message to publish
+   * @return Twist of the message, which can be changed until it is staged
+   */
+  virtual geometry_msgs::msg::Twist & prepare(const VelocityCommand & command) = 0;
+
+  virtual void stage() = 0;
+
+  /**
+   * @brief flush Publishes the message staged since the last flush, if any;
+   * the messages are published in the order they were staged
+   */
+  virtual void flush() = 0;
+};
+
+/**
+ * @brief The TwistOutput class publishes on a publisher of type T, which is
+ * resolved once when the output is created, so publishing needs no cast and
+ * no branch on the output type.
+ *
+ * The command is converted straight from the message received into the
+ * message published, which is the only copy of a command on its way to the
+ * output; the handles keep their last message by shared_ptr, and the
+ * smoothing and the deduplication work in place on the prepared message.
+ * The message is loaned by the middleware when it supports it, or is a new
+ * message published by unique_ptr otherwise, which rclcpp hands over
+ * without copying to intra-process subscribers.
+ *
+ * A preallocated output publishes by reference one of three messages
+ * allocated once, the one prepared, the one staged and the one published,
+ * so publishing does not allocate. rclcpp would copy such a message for
+ * intra-process subscribers, so a node using intra-process communication
+ * publishes by unique_ptr instead.
+ */
+template<typename T>
+class TwistOutput : public TwistOutputBase
+{
+public:
+  TwistOutput(
+    rclcpp::Node * node, const std::string & topic, const rclcpp::QoS & qos,
+    bool preallocated = false)
+  : pub_(node->create_publisher<T>(topic, qos)),
+    can_loan_messages_(pub_->can_loan_messages()),
+    preallocated_(
+      preallocated && !can_loan_messages_ && !node->get_node_options().use_intra_process_comms()),
+    staged_(false),
+    prepared_buffer_(0),
+    staged_buffer_(1),
+    published_buffer_(2)
+  {
+  }
+
+  geometry_msgs::msg::Twist & prepare(const VelocityCommand & command) override
+  {
+    T * out = nullptr;
+    if (can_loan_messages_) {
+      if (!prepared_loan_) {
+        prepared_loan_.emplace(pub_->borrow_loaned_message());
+      }
+      out = &prepared_loan_->get();
+    } else if (preallocated_) {
+      out = &buffers_[prepared_buffer_];
+    } else {
+      if (!prepared_) {
+        prepared_ = std::make_unique<T>();
+      }
+      out = prepared_.get();
+    }
+
+    command.convert(*out);
+    return twistOf(*out);
+  }
+
+  void stage() override
+  {
+    std::lock_guard<std::mutex> lock(staged_mutex_);
+    if (can_loan_messages_) {
+      staged_loan_.reset();
+      staged_loan_.emplace(std::move(*prepared_loan_));
+      prepared_loan_.reset();
+    } else if (preallocated_) {
+      std::swap(prepared_buffer_, staged_buffer_);
+    } else {
+      staged_msg_ = std::move(prepared_);
+    }
+    staged_ = true;
+  }
+
+  void flush() override
+  {
+    std::lock_guard<std::mutex> publish(publish_mutex_);
+
+    std::optional<rclcpp::LoanedMessage<T>> loan;
+    std::unique_ptr<T> msg;
+    {
+      std::lock_guard<std::mutex> lock(staged_mutex_);
+      if (!staged_) {
+        return;
+      }
+      staged_ = false;
+
+      if (can_loan_messages_) {
+        loan.emplace(std::move(*staged_loan_));
+        staged_loan_.reset();
+      } else if (preallocated_) {
+        // The writer only prepares the third message meanwhile:
+        std::swap(staged_buffer_, published_buffer_);
+      } else {
+        msg = std::move(staged_msg_);
+      }
+    }
+
+    if (can_loan_messages_) {
+      pub_->publish(std::move(*loan));
+    } else if (preallocated_) {
+      pub_->publish(buffers_[published_buffer_]);
+    } else {
+      pub_->publish(std::move(msg));
+    }
+  }
+
+private:
+  static geometry_msgs::msg::Twist & twistOf(geometry_msgs::msg::Twist & msg)
+  {
+    return msg;
+  }
+
+  static geometry_msgs::msg::Twist & twistOf(geometry_msgs::msg::TwistStamped & msg)
+  {
+    return msg.twist;
+  }
+
+  typename rclcpp::Publisher<T>::SharedPtr pub_;
+  bool can_loan_messages_;
+  bool preallocated_;
+
+  /// The staged message is handed over under staged_mutex_, and published
+  /// under publish_mutex_, so the messages are published in order:
+  std::mutex staged_mutex_;
+  std::mutex publish_mutex_;
+  bool staged_;
+
+  /// Loaned messages:
+  std::optional<rclcpp::LoanedMessage<T>> prepared_loan_;
+  std::optional<rclcpp::LoanedMessage<T>> staged_loan_;
+
+  /// Preallocated messages, by their role:
+  std::array<T, 3> buffers_;
+  std::size_t prepared_buffer_;
+  std::size_t staged_buffer_;
+  std::size_t published_buffer_;
+
+  /// Messages published by unique_ptr:
+  std::unique_ptr<T> prepared_;
+  std::unique_ptr<T> staged_msg_;
+};
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__TWIST_OUTPUT_HPP_
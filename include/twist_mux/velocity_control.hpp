@@ -0,0 +1,131 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__VELOCITY_CONTROL_HPP_
+#define TWIST_MUX__VELOCITY_CONTROL_HPP_
+
+#include <geometry_msgs/msg/twist.hpp>
+
+namespace twist_mux
+{
+/**
+ * @brief The Velocity class scales a joystick axis in [-1, 1] into a
+ * velocity, whose maximum grows linearly with the turbo step from the
+ * minimum velocity at step 1 to the maximum velocity at the last step.
+ */
+class Velocity
+{
+public:
+  /**
+   * @brief Velocity
+   * @param min_velocity Maximum velocity at step 1, usually in [m/s] or [rad/s]
+   * @param max_velocity Maximum velocity at the last step
+   * @param num_steps Number of turbo steps; with one, the minimum velocity is
+   * always used
+   * @throw std::invalid_argument if a parameter is not strictly positive
+   */
+  Velocity(double min_velocity, double max_velocity, int num_steps);
+
+  /**
+   * @brief operator() Computes the velocity
+   * @param value Joystick axis in [-1, 1]
+   * @param step Turbo step in [1, num_steps]
+   */
+  double operator()(double value, int step) const
+  {
+    return value * (min_ + step_incr_ * (step - 1));
+  }
+
+private:
+  double min_;
+  double step_incr_;
+};
+
+/**
+ * @brief The VelocityControl class scales the joystick twists with the
+ * current turbo steps, one for the linear (and angular) axes and one for the
+ * angular axis only, both in [1, num_steps].
+ */
+class VelocityControl
+{
+public:
+  /**
+   * @brief VelocityControl
+   * @param num_steps Number of turbo steps
+   * @param init_step Step the turbo starts from and is reset to
+   */
+  VelocityControl(
+    int num_steps, int init_step, const Velocity & forward, const Velocity & backward,
+    const Velocity & lateral, const Velocity & angular);
+
+  /**
+   * @brief isValid
+   * @return true if only linear x, y and angular z are set, in [-1, 1]
+   */
+  static bool isValid(const geometry_msgs::msg::Twist & cmd);
+
+  /**
+   * @brief scaleTwist Scales a joystick twist into a velocity command
+   * @param cmd Joystick twist
+   * @param twist Velocity command, zero if the joystick twist is not valid
+   * @return true if the joystick twist is valid
+   */
+  bool scaleTwist(const geometry_msgs::msg::Twist & cmd, geometry_msgs::msg::Twist & twist) const;
+
+  void increaseTurbo();
+  void decreaseTurbo();
+  void increaseAngularTurbo();
+  void decreaseAngularTurbo();
+  void resetTurbo();
+
+  int getStep() const
+  {
+    return step_;
+  }
+
+  int getAngularStep() const
+  {
+    return angular_step_;
+  }
+
+private:
+  int num_steps_;
+  int init_step_;
+
+  Velocity forward_;
+  Velocity backward_;
+  Velocity lateral_;
+  Velocity angular_;
+
+  int step_;
+  int angular_step_;
+};
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__VELOCITY_CONTROL_HPP_
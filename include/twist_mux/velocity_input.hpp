@@ -0,0 +1,176 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__VELOCITY_INPUT_HPP_
+#define TWIST_MUX__VELOCITY_INPUT_HPP_
+
+#include <builtin_interfaces/msg/time.hpp>
+#include <geometry_msgs/msg/twist.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include <std_msgs/msg/header.hpp>
+
+namespace twist_mux
+{
+/**
+ * @brief The VelocityInputTraits struct describes a message type the
+ * velocity topics can subscribe to: its name, as the 'type' parameter of a
+ * topic, and its conversion to the twist and the header the mux outputs.
+ *
+ * The message type only matters to the subscription, which keeps each
+ * message as received; the rest of the mux only sees VelocityCommand, and
+ * the message is only converted into the one published. A new input type,
+ * e.g. ackermann_msgs/msg/AckermannDriveStamped, needs a specialization:
+ *
+ *   template<>
+ *   struct VelocityInputTraits<ackermann_msgs::msg::AckermannDriveStamped>
+ *   {
+ *     static constexpr const char * type = "ackermann_msgs/msg/AckermannDriveStamped";
+ *
+ *     static void toTwist(
+ *       const ackermann_msgs::msg::AckermannDriveStamped & in,
+ *       geometry_msgs::msg::Twist & twist)
+ *     {
+ *       twist = geometry_msgs::msg::Twist();
+ *       twist.linear.x = in.drive.speed;
+ *       twist.angular.z = in.drive.speed * std::tan(in.drive.steering_angle) / WHEELBASE;
+ *     }
+ *
+ *     static void toHeader(
+ *       const ackermann_msgs::msg::AckermannDriveStamped & in,
+ *       std_msgs::msg::Header & header)
+ *     {
+ *       header = in.header;
+ *     }
+ *   };
+ *
+ * and an entry in the input types of TwistMux::createVelocityHandle().
+ */
+template<typename T>
+struct VelocityInputTraits;
+
+template<>
+struct VelocityInputTraits<geometry_msgs::msg::Twist>
+{
+  static constexpr const char * type = "geometry_msgs/msg/Twist";
+
+  static void toTwist(const geometry_msgs::msg::Twist & in, geometry_msgs::msg::Twist & twist)
+  {
+    twist = in;
+  }
+
+  /**
+   * @brief toHeader Clears the header, without releasing the storage of the
+   * frame id, so that a preallocated output does not allocate
+   */
+  static void toHeader(const geometry_msgs::msg::Twist &, std_msgs::msg::Header & header)
+  {
+    header.stamp = builtin_interfaces::msg::Time();
+    header.frame_id.clear();
+  }
+};
+
+template<>
+struct VelocityInputTraits<geometry_msgs::msg::TwistStamped>
+{
+  static constexpr const char * type = "geometry_msgs/msg/TwistStamped";
+
+  static void toTwist(
+    const geometry_msgs::msg::TwistStamped & in,
+    geometry_msgs::msg::Twist & twist)
+  {
+    twist = in.twist;
+  }
+
+  static void toHeader(
+    const geometry_msgs::msg::TwistStamped & in,
+    std_msgs::msg::Header & header)
+  {
+    header = in.header;
+  }
+};
+
+/**
+ * @brief The VelocityCommand struct refers to a message of any input type,
+ * with the conversions of its VelocityInputTraits, so that a command is
+ * only copied once, into the message published on the output.
+ */
+struct VelocityCommand
+{
+  const void * message;
+  void (* to_twist)(const void *, geometry_msgs::msg::Twist &);
+  void (* to_header)(const void *, std_msgs::msg::Header &);
+
+  /**
+   * @brief ofType Command converting messages of type T, which refers to no
+   * message yet
+   */
+  template<typename T>
+  static VelocityCommand ofType()
+  {
+    return VelocityCommand{nullptr, &toTwist<T>, &toHeader<T>};
+  }
+
+  /**
+   * @brief of Refers to 'message', which must outlive the command
+   */
+  template<typename T>
+  static VelocityCommand of(const T & message)
+  {
+    auto command = ofType<T>();
+    command.message = &message;
+    return command;
+  }
+
+  void convert(geometry_msgs::msg::Twist & out) const
+  {
+    to_twist(message, out);
+  }
+
+  void convert(geometry_msgs::msg::TwistStamped & out) const
+  {
+    to_header(message, out.header);
+    to_twist(message, out.twist);
+  }
+
+private:
+  template<typename T>
+  static void toTwist(const void * message, geometry_msgs::msg::Twist & twist)
+  {
+    VelocityInputTraits<T>::toTwist(*static_cast<const T *>(message), twist);
+  }
+
+  template<typename T>
+  static void toHeader(const void * message, std_msgs::msg::Header & header)
+  {
+    VelocityInputTraits<T>::toHeader(*static_cast<const T *>(message), header);
+  }
+};
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__VELOCITY_INPUT_HPP_
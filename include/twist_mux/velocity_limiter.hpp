@@ -0,0 +1,89 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TWIST_MUX__VELOCITY_LIMITER_HPP_
+#define TWIST_MUX__VELOCITY_LIMITER_HPP_
+
+#include <geometry_msgs/msg/twist.hpp>
+
+#include <array>
+#include <cstddef>
+
+namespace twist_mux
+{
+/**
+ * @brief The VelocityLimiter class limits the acceleration and the jerk of
+ * each axis of the output, so a switch of source does not step the command.
+ *
+ * The axes are linear x, y, z and angular x, y, z, in this order. A limit of
+ * 0 (or less) leaves the axis unlimited.
+ */
+class VelocityLimiter
+{
+public:
+  static constexpr std::size_t AXES = 6;
+
+  typedef std::array<double, AXES> axes_type;
+
+  /**
+   * @brief VelocityLimiter
+   * @param max_acceleration Maximum acceleration of each axis in [unit/s^2]
+   * @param max_jerk Maximum jerk of each axis in [unit/s^3]
+   */
+  VelocityLimiter(const axes_type & max_acceleration, const axes_type & max_jerk);
+
+  /**
+   * @brief limit Limits a command with respect to the last one
+   * @param twist Command, limited in place
+   * @param last Last command published
+   * @param dt Time since the last command in [s]
+   * @param brake If true, the axes that slow down towards zero (without
+   * changing direction) are not limited, e.g. for a stop
+   * @return true if the command has been changed to respect the limits
+   */
+  bool limit(
+    geometry_msgs::msg::Twist & twist, const geometry_msgs::msg::Twist & last, double dt,
+    bool brake = false);
+
+  /**
+   * @brief reset Forgets the acceleration of the last command, e.g. after
+   * the output has been stopped or switched to another source
+   */
+  void reset();
+
+private:
+  axes_type max_acceleration_;
+  axes_type max_jerk_;
+
+  /// Acceleration of the last command:
+  axes_type acceleration_;
+};
+
+}  // namespace twist_mux
+
+#endif  // TWIST_MUX__VELOCITY_LIMITER_HPP_
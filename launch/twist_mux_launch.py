@@ -79,7 +79,7 @@ def generate_launch_description():
                 'vertical_position': 2.0}]),
         Node(
             package='twist_mux',
-            executable='joystick_relay.py',
+            executable='joystick_relay',
             output='screen',
             remappings={('joy_vel_in', 'input_joy/cmd_vel'),
                         ('joy_vel_out', 'joy_vel')},
@@ -0,0 +1,590 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <twist_mux/arbitration_engine.hpp>
+
+#include <twist_mux/event_recorder.hpp>
+
+#include <algorithm>
+
+namespace
+{
+std::uint32_t toRecord(std::size_t id)
+{
+  return (id == std::numeric_limits<std::size_t>::max()) ?
+         twist_mux::EventRecorder::NO_ID : static_cast<std::uint32_t>(id);
+}
+}  // namespace
+
+namespace twist_mux
+{
+constexpr ArbitrationEngine::handle_id ArbitrationEngine::NO_HANDLE;
+constexpr ArbitrationEngine::group_id ArbitrationEngine::NO_GROUP;
+constexpr ArbitrationEngine::time_type ArbitrationEngine::NEVER;
+
+ArbitrationEngine::ArbitrationEngine()
+: winner_(NO_HANDLE),
+  lock_priority_(0),
+  dirty_(true),
+  winner_since_(0),
+  epoch_(NEVER),
+  now_(0),
+  winner_switches_(0),
+  state_version_(0),
+  recorder_(nullptr)
+{
+}
+
+ArbitrationEngine::group_id ArbitrationEngine::addGroup(priority_type priority)
+{
+  groups_.push_back(
+    Group{static_cast<std::uint8_t>(std::clamp(priority, 0, 255)), {}, NO_HANDLE, false});
+  dirty_ = true;
+
+  const auto group = groups_.size() - 1;
+  if (recorder_) {
+    recorder_->record(
+      EventRecorder::ADD_GROUP, now_, toRecord(group), 0, groups_[group].priority);
+  }
+  return group;
+}
+
+ArbitrationEngine::handle_id ArbitrationEngine::add(
+  priority_type priority, time_type timeout,
+  bool is_lock, group_id group)
+{
+  const auto id = size();
+
+  // Note that initially the message stamp is 0, so a handle with a timeout
+  // expires on the first update:
+  const auto deadline = (timeout > 0) ? timeout : NEVER;
+
+  priority_.push_back(static_cast<std::uint8_t>(std::clamp(priority, 0, 255)));
+  flags_.push_back(is_lock ? LOCK : 0);
+  timeout_.push_back(timeout);
+  deadline_.push_back(deadline);
+  masked_time_.push_back(0);
+  masked_since_.push_back(NEVER);
+  winner_time_.push_back(0);
+  group_.push_back(group);
+
+  if (!is_lock) {
+    if (group == NO_GROUP) {
+      top_level_.push_back(id);
+    } else {
+      groups_[group].members.push_back(id);
+      groups_[group].dirty = true;
+    }
+  }
+
+  if (timeout > 0) {
+    deadlines_.schedule(id, deadline);
+  }
+
+  dirty_ = true;
+  ++state_version_;
+
+  if (recorder_) {
+    recorder_->record(
+      is_lock ? EventRecorder::ADD_LOCK : EventRecorder::ADD_VELOCITY, now_, toRecord(id),
+      toRecord(group), priority_[id], 0, timeout);
+  }
+  return id;
+}
+
+ArbitrationEngine::handle_id ArbitrationEngine::addVelocity(
+  priority_type priority,
+  time_type timeout, group_id group)
+{
+  return add(priority, timeout, false, group);
+}
+
+ArbitrationEngine::handle_id ArbitrationEngine::addLock(priority_type priority, time_type timeout)
+{
+  return add(priority, timeout, true, NO_GROUP);
+}
+
+void ArbitrationEngine::remove(handle_id id, time_type now)
+{
+  if (recorder_) {
+    recorder_->record(EventRecorder::REMOVE, now, toRecord(id));
+  }
+
+  advance(now);
+  deadlines_.cancel(id);
+  setMasked(id, false, now);
+  ++state_version_;
+
+  const auto flags = flags_[id];
+  if (flags & LOCK) {
+    if (isLocked(id)) {
+      locks_.remove(priority_[id]);
+    }
+    flags_[id] = LOCK | REMOVED;
+    updateLockPriority(now);
+    return;
+  }
+
+  // Expired, so none of the arbitration passes ever picks it again:
+  flags_[id] = EXPIRED | REMOVED;
+
+  const auto group = group_[id];
+  auto & members = (group == NO_GROUP) ? top_level_ : groups_[group].members;
+  members.erase(std::remove(members.begin(), members.end(), id), members.end());
+  if (group != NO_GROUP && id == groups_[group].winner) {
+    groups_[group].dirty = true;
+    groupWinnerChanged(group);
+  }
+
+  if (id == winner_) {
+    if (!(flags & EXPIRED)) {
+      winner_time_[id] += now - winner_since_;
+    }
+    winner_since_ = now;
+    dirty_ = true;
+  }
+}
+
+void ArbitrationEngine::setPriority(handle_id id, priority_type priority, time_type now)
+{
+  const auto value = static_cast<std::uint8_t>(std::clamp(priority, 0, 255));
+  if (recorder_) {
+    recorder_->record(EventRecorder::SET_PRIORITY, now, toRecord(id), 0, value);
+  }
+
+  advance(now);
+  ++state_version_;
+
+  if (flags_[id] & LOCK) {
+    if (isLocked(id)) {
+      locks_.remove(priority_[id]);
+      locks_.add(value);
+    }
+    priority_[id] = value;
+    updateLockPriority(now);
+    return;
+  }
+
+  priority_[id] = value;
+  const auto group = group_[id];
+  if (group != NO_GROUP) {
+    groups_[group].dirty = true;
+  }
+  setMasked(id, isMasked(id), now);
+  dirty_ = true;
+}
+
+void ArbitrationEngine::setTimeout(handle_id id, time_type timeout)
+{
+  if (recorder_) {
+    recorder_->record(EventRecorder::SET_TIMEOUT, now_, toRecord(id), 0, 0, 0, timeout);
+  }
+
+  timeout_[id] = timeout;
+}
+
+void ArbitrationEngine::setGroupPriority(group_id group, priority_type priority, time_type now)
+{
+  const auto value = static_cast<std::uint8_t>(std::clamp(priority, 0, 255));
+  if (recorder_) {
+    recorder_->record(EventRecorder::SET_GROUP_PRIORITY, now, toRecord(group), 0, value);
+  }
+
+  advance(now);
+
+  groups_[group].priority = value;
+  ++state_version_;
+  for (const auto id : groups_[group].members) {
+    setMasked(id, isMasked(id), now);
+  }
+  dirty_ = true;
+}
+
+void ArbitrationEngine::update(time_type now)
+{
+  if (recorder_) {
+    recorder_->record(EventRecorder::UPDATE, now, EventRecorder::NO_ID);
+  }
+
+  expireDue(now);
+}
+
+void ArbitrationEngine::expireDue(time_type now)
+{
+  advance(now);
+  deadlines_.expire(now, [this](handle_id id) {expire(id);});
+}
+
+void ArbitrationEngine::expireNow(handle_id id, time_type now)
+{
+  if (recorder_) {
+    recorder_->record(EventRecorder::EXPIRE, now, toRecord(id));
+  }
+
+  expireDue(now);
+  if (flags_[id] & (EXPIRED | REMOVED)) {
+    return;
+  }
+
+  deadlines_.cancel(id);
+  deadline_[id] = now;
+  expire(id);
+}
+
+void ArbitrationEngine::advance(time_type now)
+{
+  if (epoch_ == NEVER) {
+    // Nothing is accounted before the first update:
+    epoch_ = now;
+    winner_since_ = now;
+    for (auto & since : masked_since_) {
+      if (since != NEVER) {
+        since = now;
+      }
+    }
+  }
+  now_ = now;
+}
+
+void ArbitrationEngine::expire(handle_id id)
+{
+  const auto flags = flags_[id];
+  flags_[id] = flags | EXPIRED;
+
+  // The handle expired at its deadline, which might be before the update:
+  const auto deadline = deadline_[id];
+  setMasked(id, true, deadline);
+
+  if (flags & LOCK) {
+    // A free lock becomes locked:
+    if (!(flags & LOCKED)) {
+      locks_.add(priority_[id]);
+      updateLockPriority(deadline);
+    }
+  } else {
+    const auto group = group_[id];
+    if (group != NO_GROUP && id == groups_[group].winner) {
+      groups_[group].dirty = true;
+      groupWinnerChanged(group);
+    }
+
+    if (id == winner_) {
+      // Any other velocity handle expiring is already beaten. The winner
+      // stops winning at its deadline, even if the next one is only known
+      // later:
+      const auto since = std::max(deadline, winner_since_);
+      winner_time_[id] += since - winner_since_;
+      winner_since_ = since;
+      dirty_ = true;
+    }
+  }
+}
+
+void ArbitrationEngine::updateLockPriority(time_type now)
+{
+  const auto lock_priority = locks_.highest();
+  if (lock_priority != lock_priority_) {
+    lock_priority_ = lock_priority;
+    dirty_ = true;
+
+    // Only here the masking of many velocity handles can change at once:
+    for (handle_id id = 0; id < size(); ++id) {
+      if (!(flags_[id] & (LOCK | REMOVED))) {
+        setMasked(id, isMasked(id), now);
+      }
+    }
+  }
+}
+
+void ArbitrationEngine::refresh(handle_id id, time_type now)
+{
+  // An expired winner that comes back before the next recompute wins again
+  // from now on:
+  if (id == winner_ && hasExpired(id)) {
+    winner_since_ = now;
+  }
+
+  flags_[id] &= ~EXPIRED;
+  if (timeout_[id] > 0) {
+    deadline_[id] = now + timeout_[id];
+    deadlines_.schedule(id, deadline_[id]);
+  } else if (deadline_[id] != NEVER) {
+    // The timeout was removed, or the handle expired on an event:
+    deadline_[id] = NEVER;
+    deadlines_.cancel(id);
+  }
+
+  setMasked(id, (flags_[id] & LOCK) ? isLocked(id) : isMasked(id), now);
+}
+
+void ArbitrationEngine::setMasked(handle_id id, bool masked, time_type now)
+{
+  now = std::max(now, epoch_);
+
+  const bool was_masked = masked_since_[id] != NEVER;
+  if (masked && !was_masked) {
+    masked_since_[id] = now;
+    ++state_version_;
+  } else if (!masked && was_masked) {
+    masked_time_[id] += now - masked_since_[id];
+    masked_since_[id] = NEVER;
+    ++state_version_;
+  }
+}
+
+void ArbitrationEngine::setWinner(handle_id id, time_type now)
+{
+  if (id == winner_) {
+    return;
+  }
+
+  // An expired winner has already been accounted until its deadline:
+  if (winner_ != NO_HANDLE && !hasExpired(winner_)) {
+    winner_time_[winner_] += now - winner_since_;
+  }
+  if (recorder_) {
+    recorder_->record(EventRecorder::WINNER, now, toRecord(id), toRecord(winner_));
+  }
+
+  winner_ = id;
+  winner_since_ = now;
+  ++winner_switches_;
+  ++state_version_;
+}
+
+bool ArbitrationEngine::velocityReceived(handle_id id, time_type now)
+{
+  // Recorded before any change of winner it causes, and completed with the
+  // decision on return:
+  EventRecorder::Record * record = recorder_ ?
+    recorder_->record(EventRecorder::VELOCITY, now, toRecord(id)) : nullptr;
+
+  const bool won = arbitrate(id, now);
+  if (record) {
+    record->flag = won;
+  }
+  return won;
+}
+
+bool ArbitrationEngine::arbitrate(handle_id id, time_type now)
+{
+  // A callback already running when its handle was removed:
+  if (flags_[id] & REMOVED) {
+    return false;
+  }
+
+  expireDue(now);
+  refresh(id, now);
+
+  // Within a group, only the group winner competes:
+  const auto group_id = group_[id];
+  if (group_id != NO_GROUP) {
+    auto & group = groups_[group_id];
+    const auto previous_winner = group.winner;
+
+    if (group.dirty) {
+      recomputeGroup(group_id);
+    } else if (id != group.winner && outranksInGroup(id, group.winner)) {
+      group.winner = id;
+    }
+
+    if (group.winner != previous_winner) {
+      groupWinnerChanged(group_id);
+    }
+
+    if (id != group.winner) {
+      if (dirty_) {
+        recompute();
+      }
+      return false;
+    }
+  }
+
+  if (dirty_) {
+    recompute();
+  } else if (id != winner_ && getTopPriority(id) >= lock_priority_ && outranks(id)) {
+    // The handle has just been refreshed, so it is not expired, and no other
+    // handle can beat it because none of them beats the current winner.
+    setWinner(id, now);
+  }
+
+  return id == winner_;
+}
+
+void ArbitrationEngine::lockReceived(handle_id id, bool locked, time_type now)
+{
+  if (recorder_) {
+    recorder_->record(EventRecorder::LOCK, now, toRecord(id), 0, 0, locked);
+  }
+
+  if (flags_[id] & REMOVED) {
+    return;
+  }
+
+  expireDue(now);
+
+  const bool was_locked = isLocked(id);
+
+  if (locked) {
+    flags_[id] |= LOCKED;
+  } else {
+    flags_[id] &= ~LOCKED;
+  }
+  refresh(id, now);
+
+  // A heartbeat that keeps the lock in the same state cannot change the
+  // winner, and neither can a lock that does not change the highest
+  // priority of the active locks.
+  if (was_locked != locked) {
+    if (locked) {
+      locks_.add(priority_[id]);
+    } else {
+      locks_.remove(priority_[id]);
+    }
+    updateLockPriority(now);
+  }
+}
+
+ArbitrationEngine::handle_id ArbitrationEngine::getWinner()
+{
+  if (dirty_) {
+    recompute();
+  }
+  return winner_;
+}
+
+ArbitrationEngine::priority_type ArbitrationEngine::getLockPriority() const
+{
+  return lock_priority_;
+}
+
+ArbitrationEngine::time_type ArbitrationEngine::getMaskedTime(handle_id id, time_type now) const
+{
+  const auto since = masked_since_[id];
+  return masked_time_[id] + ((since != NEVER && since < now) ? now - since : 0);
+}
+
+ArbitrationEngine::time_type ArbitrationEngine::getWinnerTime(handle_id id, time_type now) const
+{
+  const bool winning = id == winner_ && !hasExpired(id) && winner_since_ < now;
+  return winner_time_[id] + (winning ? now - winner_since_ : 0);
+}
+
+bool ArbitrationEngine::outranks(handle_id id) const
+{
+  const priority_type priority = getTopPriority(id);
+
+  // As the priority of the winner starts at 0, a handle with priority 0
+  // never wins.
+  if (winner_ == NO_HANDLE) {
+    return 0 < priority;
+  }
+
+  const priority_type winner_priority = getTopPriority(winner_);
+  return (winner_priority < priority) || (winner_priority == priority && id < winner_);
+}
+
+bool ArbitrationEngine::outranksInGroup(handle_id id, handle_id winner) const
+{
+  const priority_type priority = priority_[id];
+
+  if (winner == NO_HANDLE) {
+    return 0 < priority;
+  }
+
+  const priority_type winner_priority = priority_[winner];
+  return (winner_priority < priority) || (winner_priority == priority && id < winner);
+}
+
+void ArbitrationEngine::groupWinnerChanged(group_id group)
+{
+  // The group winner competes with the priority of the group, so it cannot
+  // change a winner of higher priority:
+  if (winner_ == NO_HANDLE || groups_[group].priority >= getTopPriority(winner_)) {
+    dirty_ = true;
+  }
+}
+
+void ArbitrationEngine::recomputeGroup(group_id group_id)
+{
+  auto & group = groups_[group_id];
+
+  group.winner = NO_HANDLE;
+  for (const auto id : group.members) {
+    if (!(flags_[id] & EXPIRED) && outranksInGroup(id, group.winner)) {
+      group.winner = id;
+    }
+  }
+
+  group.dirty = false;
+}
+
+void ArbitrationEngine::recompute()
+{
+  const auto count = size();
+  const auto previous_winner = winner_;
+
+  /// max_element on the priority of velocity handles satisfying that is NOT
+  /// masked by the lock priority:
+  winner_ = NO_HANDLE;
+  if (groups_.empty()) {
+    // The flat scan touches the least memory:
+    for (handle_id id = 0; id < count; ++id) {
+      if (!(flags_[id] & (LOCK | EXPIRED)) && priority_[id] >= lock_priority_ && outranks(id)) {
+        winner_ = id;
+      }
+    }
+  } else {
+    for (const auto id : top_level_) {
+      if (!(flags_[id] & EXPIRED) && priority_[id] >= lock_priority_ && outranks(id)) {
+        winner_ = id;
+      }
+    }
+    for (group_id group_id = 0; group_id < groups_.size(); ++group_id) {
+      auto & group = groups_[group_id];
+      if (group.dirty) {
+        recomputeGroup(group_id);
+      }
+      if (group.winner != NO_HANDLE && group.priority >= lock_priority_ &&
+        outranks(group.winner))
+      {
+        winner_ = group.winner;
+      }
+    }
+  }
+
+  // The winner changes at the time of the last update, as getWinner() does
+  // not know the time:
+  const auto winner = winner_;
+  winner_ = previous_winner;
+  setWinner(winner, now_);
+
+  dirty_ = false;
+}
+
+}  // namespace twist_mux
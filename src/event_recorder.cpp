@@ -0,0 +1,290 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <twist_mux/event_recorder.hpp>
+#include <twist_mux/arbitration_engine.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+constexpr char MAGIC[8] = {'T', 'W', 'M', 'X', 'R', 'E', 'C', '\0'};
+constexpr std::uint32_t VERSION = 1;
+
+typedef twist_mux::EventRecorder::Record Record;
+typedef twist_mux::EventRecorder::Header Header;
+
+std::size_t fileSize(std::size_t setup_capacity, std::size_t capacity)
+{
+  return sizeof(Header) + (setup_capacity + capacity) * sizeof(Record);
+}
+
+twist_mux::ArbitrationEngine::handle_id toHandle(std::uint32_t id)
+{
+  return (id == twist_mux::EventRecorder::NO_ID) ? twist_mux::ArbitrationEngine::NO_HANDLE : id;
+}
+}  // namespace
+
+namespace twist_mux
+{
+constexpr std::uint32_t EventRecorder::NO_ID;
+
+EventRecorder::EventRecorder(
+  const std::string & path, std::size_t capacity,
+  std::size_t setup_capacity)
+: header_(nullptr),
+  setup_(nullptr),
+  events_(nullptr),
+  size_(fileSize(setup_capacity, std::max<std::size_t>(capacity, 2))),
+  sequence_(0)
+{
+  capacity = std::max<std::size_t>(capacity, 2);
+
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "could not open " + path);
+  }
+
+  if (::ftruncate(fd, static_cast<off_t>(size_)) != 0) {
+    const int error = errno;
+    ::close(fd);
+    throw std::system_error(error, std::generic_category(), "could not resize " + path);
+  }
+
+  void * mapping = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const int error = errno;
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::system_error(error, std::generic_category(), "could not map " + path);
+  }
+
+  // The file is zeroed by ftruncate, so only the header needs to be set:
+  header_ = new (mapping) Header;
+  std::memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+  header_->version = VERSION;
+  header_->record_size = sizeof(Record);
+  header_->setup_capacity = setup_capacity;
+  header_->capacity = capacity;
+  header_->setup_count.store(0, std::memory_order_relaxed);
+  header_->event_count.store(0, std::memory_order_relaxed);
+  header_->setup_dropped.store(0, std::memory_order_relaxed);
+
+  setup_ = reinterpret_cast<Record *>(header_ + 1);
+  events_ = setup_ + setup_capacity;
+}
+
+EventRecorder::~EventRecorder()
+{
+  ::munmap(header_, size_);
+}
+
+EventRecorder::Record * EventRecorder::record(
+  Type type, time_type stamp, std::uint32_t id, std::uint32_t arg,
+  std::uint16_t priority, std::uint8_t flag, std::int64_t value)
+{
+  Record * slot = nullptr;
+  if (type < VELOCITY) {
+    const auto count = header_->setup_count.load(std::memory_order_relaxed);
+    if (count == header_->setup_capacity) {
+      header_->setup_dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    slot = setup_ + count;
+  } else {
+    const auto count = header_->event_count.load(std::memory_order_relaxed);
+    slot = events_ + count % header_->capacity;
+  }
+
+  *slot = Record{sequence_++, stamp, value, id, arg, type, flag, priority, 0};
+
+  // The counters are published once the record is complete, for a reader
+  // mapping the file while it is written:
+  auto & counter = (type < VELOCITY) ? header_->setup_count : header_->event_count;
+  counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+  return slot;
+}
+
+std::vector<EventRecorder::Record> EventRecorder::read(
+  const std::string & path,
+  std::uint64_t * setup_dropped)
+{
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("could not open " + path + ": " + std::strerror(errno));
+  }
+
+  struct stat status;
+  if (::fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(Header)) {
+    ::close(fd);
+    throw std::runtime_error(path + " is not a twist_mux trace");
+  }
+  const auto size = static_cast<std::size_t>(status.st_size);
+
+  void * mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("could not map " + path + ": " + std::strerror(errno));
+  }
+
+  const auto * header = static_cast<const Header *>(mapping);
+  if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+    header->record_size != sizeof(Record) ||
+    size < fileSize(header->setup_capacity, header->capacity))
+  {
+    ::munmap(mapping, size);
+    throw std::runtime_error(path + " is not a twist_mux trace of this version");
+  }
+
+  const auto * setup = reinterpret_cast<const Record *>(header + 1);
+  const auto * events = setup + header->setup_capacity;
+
+  const auto setup_count = std::min(
+    header->setup_count.load(std::memory_order_acquire), header->setup_capacity);
+  const auto event_count = header->event_count.load(std::memory_order_acquire);
+  const auto retained = std::min(event_count, header->capacity);
+
+  std::vector<Record> records(setup, setup + setup_count);
+  records.reserve(setup_count + retained);
+  for (auto i = event_count - retained; i < event_count; ++i) {
+    records.push_back(events[i % header->capacity]);
+  }
+
+  if (setup_dropped) {
+    *setup_dropped = header->setup_dropped.load(std::memory_order_relaxed);
+  }
+  ::munmap(mapping, size);
+
+  std::sort(
+    records.begin(), records.end(),
+    [](const Record & a, const Record & b) {return a.sequence < b.sequence;});
+  return records;
+}
+
+ReplayResult replay(const std::vector<EventRecorder::Record> & records, ArbitrationEngine & engine)
+{
+  ReplayResult result;
+  result.records = records.size();
+
+  auto mismatch = [&result](const EventRecorder::Record & record) {
+      if (result.mismatches++ == 0) {
+        result.first_mismatch = record.sequence;
+      }
+    };
+
+  bool has_event = false;
+  EventRecorder::time_type first_event = 0;
+  for (const auto & record : records) {
+    const auto id = toHandle(record.id);
+    bool applied = true;
+
+    if (record.type >= EventRecorder::VELOCITY) {
+      if (!has_event) {
+        has_event = true;
+        first_event = record.stamp;
+      }
+      result.span = record.stamp - first_event;
+    }
+
+    switch (record.type) {
+      case EventRecorder::ADD_GROUP:
+        if (engine.addGroup(record.priority) != id) {
+          mismatch(record);
+        }
+        break;
+      case EventRecorder::ADD_VELOCITY:
+        {
+          const auto group = (record.arg == EventRecorder::NO_ID) ?
+            ArbitrationEngine::NO_GROUP : ArbitrationEngine::group_id(record.arg);
+          if (engine.addVelocity(record.priority, record.value, group) != id) {
+            mismatch(record);
+          }
+          break;
+        }
+      case EventRecorder::ADD_LOCK:
+        if (engine.addLock(record.priority, record.value) != id) {
+          mismatch(record);
+        }
+        break;
+      case EventRecorder::REMOVE:
+        engine.remove(id, record.stamp);
+        break;
+      case EventRecorder::SET_PRIORITY:
+        engine.setPriority(id, record.priority, record.stamp);
+        break;
+      case EventRecorder::SET_TIMEOUT:
+        engine.setTimeout(id, record.value);
+        break;
+      case EventRecorder::SET_GROUP_PRIORITY:
+        engine.setGroupPriority(id, record.priority, record.stamp);
+        break;
+      case EventRecorder::VELOCITY:
+        if (engine.velocityReceived(id, record.stamp) != (record.flag != 0)) {
+          mismatch(record);
+        }
+        break;
+      case EventRecorder::LOCK:
+        engine.lockReceived(id, record.flag != 0, record.stamp);
+        break;
+      case EventRecorder::UPDATE:
+        engine.update(record.stamp);
+        break;
+      case EventRecorder::EXPIRE:
+        engine.expireNow(id, record.stamp);
+        break;
+      case EventRecorder::WINNER:
+        // Recorded when the winner changed, so by now it must be the same:
+        if (engine.getWinner() != id) {
+          mismatch(record);
+        }
+        applied = false;
+        break;
+      default:
+        applied = false;
+        break;
+    }
+
+    if (applied) {
+      ++result.operations;
+    }
+  }
+
+  return result;
+}
+
+}  // namespace twist_mux
@@ -0,0 +1,177 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <twist_mux/joystick_relay.hpp>
+
+#include <rclcpp_components/register_node_macro.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace twist_mux
+{
+JoystickRelay::JoystickRelay(const rclcpp::NodeOptions & options)
+: Node("joystick_relay", options)
+{
+  priority_.data = this->declare_parameter("priority", true);
+
+  const int num_steps = this->declare_parameter("turbo.steps", 1);
+
+  const double forward_min = this->declare_parameter("turbo.linear_forward_min", 1.0);
+  const double forward_max = this->declare_parameter("turbo.linear_forward_max", 1.0);
+  const double backward_min = this->declare_parameter("turbo.linear_backward_min", forward_min);
+  const double backward_max = this->declare_parameter("turbo.linear_backward_max", forward_max);
+  const double lateral_min = this->declare_parameter("turbo.linear_lateral_min", 1.0);
+  const double lateral_max = this->declare_parameter("turbo.linear_lateral_max", 1.0);
+  const double angular_min = this->declare_parameter("turbo.angular_min", 1.0);
+  const double angular_max = this->declare_parameter("turbo.angular_max", 1.0);
+
+  const int default_init_step = (num_steps + 1) / 2;
+  int init_step = this->declare_parameter("turbo.init_step", default_init_step);
+  if (init_step < 1 || init_step > num_steps) {
+    RCLCPP_WARN(
+      this->get_logger(), "Initial step %d outside range [1, %d]! Falling back to default %d",
+      init_step, num_steps, default_init_step);
+    init_step = default_init_step;
+  }
+
+  velocity_control_ = std::make_unique<VelocityControl>(
+    num_steps, init_step,
+    Velocity(forward_min, forward_max, num_steps),
+    Velocity(backward_min, backward_max, num_steps),
+    Velocity(lateral_min, lateral_max, num_steps),
+    Velocity(angular_min, angular_max, num_steps));
+
+  // Text marker showing who has priority:
+  marker_.id = 0;
+  marker_.type = visualization_msgs::msg::Marker::TEXT_VIEW_FACING;
+  marker_.header.frame_id = "base_footprint";
+  marker_.pose.position.z = 2.0;
+  marker_.pose.orientation.w = 1.0;
+  marker_.scale.z = 0.5;
+  marker_.color.a = 1.0;
+  marker_.color.r = 1.0;
+  marker_.color.g = 1.0;
+  marker_.color.b = 1.0;
+
+  const auto latched = rclcpp::QoS(rclcpp::KeepLast(1)).transient_local();
+
+  marker_pub_ = this->create_publisher<visualization_msgs::msg::Marker>("text_marker", latched);
+  cmd_pub_ = this->create_publisher<geometry_msgs::msg::Twist>("joy_vel_out", 1);
+  cmd_sub_ = this->create_subscription<geometry_msgs::msg::Twist>(
+    "joy_vel_in", 1,
+    [this](const geometry_msgs::msg::Twist::ConstSharedPtr cmd) {forwardCommand(*cmd);});
+  priority_pub_ = this->create_publisher<std_msgs::msg::Bool>("joy_priority", latched);
+
+  // Publish the initial joy_priority, latched for the late subscribers:
+  priority_pub_->publish(priority_);
+  updateMarker();
+
+  marker_timer_ = this->create_wall_timer(std::chrono::seconds(1), [this]() {updateMarker();});
+
+  auto & control = *velocity_control_;
+  priority_server_ = createActionServer<twist_mux_msgs::action::JoyPriority>(
+    "joy_priority_action", [this]() {togglePriority();});
+  increase_server_ = createActionServer<twist_mux_msgs::action::JoyTurbo>(
+    "joy_turbo_increase", [&control]() {control.increaseTurbo();});
+  decrease_server_ = createActionServer<twist_mux_msgs::action::JoyTurbo>(
+    "joy_turbo_decrease", [&control]() {control.decreaseTurbo();});
+  angular_increase_server_ = createActionServer<twist_mux_msgs::action::JoyTurbo>(
+    "joy_turbo_angular_increase", [&control]() {control.increaseAngularTurbo();});
+  angular_decrease_server_ = createActionServer<twist_mux_msgs::action::JoyTurbo>(
+    "joy_turbo_angular_decrease", [&control]() {control.decreaseAngularTurbo();});
+  reset_server_ = createActionServer<twist_mux_msgs::action::JoyTurbo>(
+    "joy_turbo_reset", [&control]() {control.resetTurbo();});
+}
+
+void JoystickRelay::forwardCommand(const geometry_msgs::msg::Twist & cmd)
+{
+  if (priority_.data) {
+    // Published by ownership, so an intra-process mux takes it without a copy:
+    auto twist = std::make_unique<geometry_msgs::msg::Twist>();
+    if (!velocity_control_->scaleTwist(cmd, *twist)) {
+      RCLCPP_ERROR(
+        this->get_logger(),
+        "Joystick provided invalid values (%g, %g, %g), only linear.x, linear.y and "
+        "angular.z may be non-zero, in [-1, 1] range.",
+        cmd.linear.x, cmd.linear.y, cmd.angular.z);
+    }
+    cmd_pub_->publish(std::move(twist));
+  }
+
+  updateMarker();
+}
+
+void JoystickRelay::togglePriority()
+{
+  priority_.data = !priority_.data;
+  RCLCPP_INFO(
+    this->get_logger(), "Toggled joy_priority, current status is: %s",
+    priority_.data ? "True" : "False");
+  priority_pub_->publish(priority_);
+  updateMarker();
+
+  // Reset velocity to 0:
+  if (priority_.data) {
+    cmd_pub_->publish(geometry_msgs::msg::Twist());
+  }
+}
+
+template<typename ActionT>
+typename rclcpp_action::Server<ActionT>::SharedPtr JoystickRelay::createActionServer(
+  const std::string & name, std::function<void()> callback)
+{
+  typedef rclcpp_action::ServerGoalHandle<ActionT> goal_handle_type;
+
+  // Used like a service: every goal is executed and succeeds when accepted.
+  return rclcpp_action::create_server<ActionT>(
+    this, name,
+    [](const rclcpp_action::GoalUUID &, std::shared_ptr<const typename ActionT::Goal>) {
+      return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+    },
+    [](const std::shared_ptr<goal_handle_type>) {
+      return rclcpp_action::CancelResponse::REJECT;
+    },
+    [callback](const std::shared_ptr<goal_handle_type> goal) {
+      callback();
+      goal->succeed(std::make_shared<typename ActionT::Result>());
+    });
+}
+
+void JoystickRelay::updateMarker()
+{
+  marker_.action = visualization_msgs::msg::Marker::ADD;
+  marker_.text = priority_.data ? "Manual" : "Autonomous";
+
+  marker_pub_->publish(marker_);
+}
+
+}  // namespace twist_mux
+
+RCLCPP_COMPONENTS_REGISTER_NODE(twist_mux::JoystickRelay)
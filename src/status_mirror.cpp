@@ -0,0 +1,191 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <twist_mux/status_mirror.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+constexpr char MAGIC[8] = {'T', 'W', 'M', 'X', 'S', 'T', 'S', '\0'};
+constexpr std::uint32_t VERSION = 1;
+
+typedef twist_mux::StatusMirror::Segment Segment;
+
+std::int64_t monotonicNs()
+{
+  timespec now;
+  ::clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<std::int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+void * map(const std::string & name, bool writable)
+{
+  const int fd = writable ?
+    ::shm_open(name.c_str(), O_RDWR | O_CREAT, 0644) : ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "could not open " + name);
+  }
+
+  if (writable && ::ftruncate(fd, static_cast<off_t>(sizeof(Segment))) != 0) {
+    const int error = errno;
+    ::close(fd);
+    throw std::system_error(error, std::generic_category(), "could not resize " + name);
+  }
+
+  struct stat info;
+  if (!writable && (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Segment))))
+  {
+    ::close(fd);
+    throw std::runtime_error(name + " is not a status mirror");
+  }
+
+  void * mapping = ::mmap(
+    nullptr, sizeof(Segment), writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+  const int error = errno;
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::system_error(error, std::generic_category(), "could not map " + name);
+  }
+  return mapping;
+}
+}  // namespace
+
+namespace twist_mux
+{
+constexpr std::uint32_t StatusMirror::NO_ID;
+constexpr std::int64_t StatusMirror::READ_TIMEOUT;
+constexpr std::size_t StatusMirror::WORDS;
+
+StatusMirror::StatusMirror(const std::string & name)
+: name_(name),
+  segment_(nullptr),
+  sequence_(0)
+{
+  segment_ = new (map(name_, true)) Segment;
+
+  // A segment left by a previous run is reset; the magic is set last, so a
+  // reader never takes a half-initialized segment:
+  std::memset(segment_->magic, 0, sizeof(segment_->magic));
+  segment_->version = VERSION;
+  segment_->size = sizeof(Segment);
+  segment_->lock.store(0, std::memory_order_relaxed);
+  for (auto & word : segment_->words) {
+    word.store(0, std::memory_order_relaxed);
+  }
+
+  Status status{};
+  status.winner = NO_ID;
+  update(status);
+
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(segment_->magic, MAGIC, sizeof(MAGIC));
+}
+
+StatusMirror::~StatusMirror()
+{
+  ::munmap(segment_, sizeof(Segment));
+  ::shm_unlink(name_.c_str());
+}
+
+void StatusMirror::update(Status & status)
+{
+  status.sequence = ++sequence_;
+  status.heartbeat = monotonicNs();
+
+  std::uint64_t words[WORDS];
+  std::memcpy(words, &status, sizeof(status));
+
+  const auto lock = segment_->lock.load(std::memory_order_relaxed);
+  segment_->lock.store(lock + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  for (std::size_t i = 0; i < WORDS; ++i) {
+    segment_->words[i].store(words[i], std::memory_order_relaxed);
+  }
+
+  segment_->lock.store(lock + 2, std::memory_order_release);
+}
+
+bool StatusMirror::tryRead(const Segment & segment, Status & status, std::int64_t timeout)
+{
+  std::uint64_t words[WORDS];
+  std::int64_t deadline = 0;
+  for (;;) {
+    const auto before = segment.lock.load(std::memory_order_acquire);
+    if ((before & 1) == 0) {
+      for (std::size_t i = 0; i < WORDS; ++i) {
+        words[i] = segment.words[i].load(std::memory_order_relaxed);
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (segment.lock.load(std::memory_order_relaxed) == before) {
+        break;
+      }
+    }
+
+    // The clock is only read once the first attempt failed:
+    const auto now = monotonicNs();
+    if (deadline == 0) {
+      deadline = now + timeout;
+    } else if (now >= deadline) {
+      return false;
+    }
+  }
+
+  std::memcpy(&status, words, sizeof(status));
+  return true;
+}
+
+StatusMirrorReader::StatusMirrorReader(const std::string & name)
+: segment_(static_cast<const Segment *>(map(name, false)))
+{
+  if (std::memcmp(segment_->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+    segment_->version != VERSION || segment_->size != sizeof(Segment))
+  {
+    ::munmap(const_cast<Segment *>(segment_), sizeof(Segment));
+    throw std::runtime_error(name + " is not a status mirror");
+  }
+}
+
+StatusMirrorReader::~StatusMirrorReader()
+{
+  ::munmap(const_cast<Segment *>(segment_), sizeof(Segment));
+}
+
+}  // namespace twist_mux
@@ -36,12 +36,66 @@
 #include <twist_mux/topic_handle.hpp>
 #include <twist_mux/twist_mux_diagnostics.hpp>
 #include <twist_mux/twist_mux_diagnostics_status.hpp>
+#include <twist_mux/twist_output.hpp>
+#include <twist_mux/velocity_input.hpp>
+#include <twist_mux/velocity_limiter.hpp>
 #include <twist_mux/utils.hpp>
 #include <twist_mux/params_helpers.hpp>
 
-#include <list>
+#include <rclcpp_components/register_node_macro.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace
+{
+typedef std::shared_ptr<twist_mux::VelocityTopicHandle> (* velocity_handle_factory)(
+  const std::string &, const std::string &, const rclcpp::Duration &, int,
+  twist_mux::TwistMux *, twist_mux::ArbitrationEngine::group_id, const rclcpp::QoS &);
+
+/**
+ * @brief velocityInputs
+ * @return Factories of the velocity handles, by input type; a new input type
+ * needs a VelocityInputTraits specialization and an entry here
+ */
+const std::map<std::string, velocity_handle_factory> & velocityInputs()
+{
+  static const std::map<std::string, velocity_handle_factory> inputs{
+    {twist_mux::VelocityInputTraits<geometry_msgs::msg::Twist>::type,
+      &twist_mux::VelocityTopicHandle::create<geometry_msgs::msg::Twist>},
+    {twist_mux::VelocityInputTraits<geometry_msgs::msg::TwistStamped>::type,
+      &twist_mux::VelocityTopicHandle::create<geometry_msgs::msg::TwistStamped>},
+  };
+  return inputs;
+}
+
+/**
+ * @brief childPrefixes
+ * @return Prefixes of 'list' right under 'param_name', e.g. topics.joystick
+ * for topics, without those of the nested parameters, e.g.
+ * topics.joystick.qos
+ */
+std::vector<std::string> childPrefixes(
+  const rcl_interfaces::msg::ListParametersResult & list, const std::string & param_name)
+{
+  std::vector<std::string> prefixes;
+  for (const auto & prefix : list.prefixes) {
+    if (prefix.size() > param_name.size() &&
+      prefix.find('.', param_name.size() + 1) == std::string::npos)
+    {
+      prefixes.push_back(prefix);
+    }
+  }
+  return prefixes;
+}
+}  // namespace
 
 /**
  * @brief hasIncreasedAbsVelocity Check if the absolute velocity has increased
@@ -67,22 +121,174 @@ namespace twist_mux
 {
 // see e.g. https://stackoverflow.com/a/40691657
 constexpr std::chrono::duration<int64_t> TwistMux::DIAGNOSTICS_PERIOD;
+constexpr std::chrono::milliseconds TwistMux::EXPIRY_CHECK_PERIOD;
+constexpr std::chrono::milliseconds TwistMux::RECONFIGURE_DELAY;
+constexpr std::chrono::milliseconds TwistMux::READY_CHECK_PERIOD;
+
+TwistMux::TwistMux(const rclcpp::NodeOptions & options)
+: TwistMux(std::nullopt, options, nullptr)
+{
+}
+
+TwistMux::TwistMux(const Configuration & configuration, const rclcpp::NodeOptions & options)
+: TwistMux(std::optional<Configuration>(configuration), options, nullptr)
+{
+}
+
+TwistMux::TwistMux(
+  const rclcpp::NodeOptions & options,
+  std::shared_ptr<diagnostic_updater::Updater> diagnostics)
+: TwistMux(std::nullopt, options, std::move(diagnostics))
+{
+}
 
-TwistMux::TwistMux()
+TwistMux::TwistMux(
+  std::optional<Configuration> configuration, const rclcpp::NodeOptions & options,
+  std::shared_ptr<diagnostic_updater::Updater> diagnostics)
 : Node("twist_mux", "",
-    rclcpp::NodeOptions().allow_undeclared_parameters(
-      true).automatically_declare_parameters_from_overrides(true)), output_stamped(false)
+    rclcpp::NodeOptions(options).allow_undeclared_parameters(
+      true).automatically_declare_parameters_from_overrides(true)),
+  compiled_configuration_(std::move(configuration)),
+  host_diagnostics_(std::move(diagnostics)),
+  mirror_status_(),
+  mirror_winner_(ArbitrationEngine::NO_HANDLE),
+  command_threads_(0),
+  message_pool_size_(0),
+  min_output_interval_(0),
+  fixed_rate_output_(false),
+  deduplicate_output_(false),
+  output_pending_(false),
+  has_output_(false),
+  lock_transition_time_(0),
+  last_lock_priority_(0),
+  output_stamped(false),
+  failsafe_enabled_(false),
+  failsafe_command_(VelocityCommand::of(failsafe_cmd_)),
+  active_(ArbitrationEngine::NO_HANDLE),
+  handover_latency_(0),
+  max_handover_latency_(0),
+  output_lock_priority_(0),
+  stop_command_(VelocityCommand::of(stop_cmd_)),
+  ready_(false),
+  start_time_(std::chrono::steady_clock::now()),
+  active_source_winner_(ArbitrationEngine::NO_HANDLE),
+  active_source_lock_priority_(-1)
 {
+  // Initialized here so the node is ready when loaded as a component:
+  init();
 }
 
+TwistMux::~TwistMux() = default;
+
 void TwistMux::init()
 {
-  /// Get topics and locks:
+  auto nh = std::shared_ptr<rclcpp::Node>(this, [](rclcpp::Node *) {});
+
+  /// Multi-threaded mode, which must be known before creating the handles:
+  bool multi_threaded = false;
+  int command_threads = 0;
+  fetch_param_or(nh, "multi_threaded.enabled", multi_threaded, false);
+  fetch_param_or(nh, "multi_threaded.threads", command_threads, 0);
+  if (multi_threaded) {
+    command_group_ = create_callback_group(rclcpp::CallbackGroupType::Reentrant);
+    command_threads_ = static_cast<std::size_t>(std::max(command_threads, 0));
+  }
+
+  /// Memory pool, which must also be known before creating the handles:
+  bool memory_pool = false;
+  int message_pool_size = 0;
+  fetch_param_or(nh, "memory_pool.enabled", memory_pool, false);
+  fetch_param_or(nh, "memory_pool.size", message_pool_size, 4);
+  if (memory_pool) {
+    message_pool_size_ = static_cast<std::size_t>(std::max(message_pool_size, 1));
+  }
+
+  /// The trace and the status mirror are named after the node by default,
+  /// e.g. /robot1_twist_mux for the mux in the namespace robot1, so the muxes
+  /// of a process have their own:
+  std::string node_name = get_fully_qualified_name();
+  std::replace(node_name.begin() + 1, node_name.end(), '/', '_');
+
+  /// Recording, which must start before the handles are added:
+  bool recording = false;
+  std::string recording_path;
+  int recording_size = 0;
+  fetch_param_or(nh, "recording.enabled", recording, false);
+  fetch_param_or(nh, "recording.path", recording_path, "/tmp" + node_name + ".rec");
+  fetch_param_or(nh, "recording.size", recording_size, 65536);
+  if (recording) {
+    try {
+      recorder_ = std::make_unique<EventRecorder>(
+        recording_path, static_cast<std::size_t>(std::max(recording_size, 2)));
+      arbitration_.setRecorder(recorder_.get());
+      RCLCPP_INFO(
+        get_logger(), "Recording the arbitration to %s.", recording_path.c_str());
+    } catch (const std::system_error & e) {
+      RCLCPP_ERROR(get_logger(), "Not recording the arbitration: %s.", e.what());
+    }
+  }
+
+  /// Status mirror:
+  bool status_mirror = false;
+  std::string status_mirror_name;
+  fetch_param_or(nh, "status_mirror.enabled", status_mirror, false);
+  fetch_param_or(nh, "status_mirror.name", status_mirror_name, node_name + "_status");
+  if (status_mirror) {
+    try {
+      status_mirror_ = std::make_unique<StatusMirror>(status_mirror_name);
+      RCLCPP_INFO(
+        get_logger(), "Mirroring the status to shared memory %s.", status_mirror_name.c_str());
+    } catch (const std::system_error & e) {
+      RCLCPP_ERROR(get_logger(), "Not mirroring the status: %s.", e.what());
+    }
+  }
+
+  /// Get groups, topics and locks, unless they are compiled in:
+  if (compiled_configuration_) {
+    try {
+      validate(*compiled_configuration_);
+    } catch (const ParamsHelperException & e) {
+      RCLCPP_FATAL(get_logger(), "Invalid compiled configuration:\n\t%s", e.what());
+      throw;
+    }
+  }
+  const auto configuration =
+    compiled_configuration_ ? *compiled_configuration_ : readConfiguration();
+  const auto & groups = configuration.groups;
+  const auto & velocities = configuration.velocities;
+  const auto & locks = configuration.locks;
+
+  for (const auto & group : groups) {
+    // Only the multi-threaded mode has threads to give to the groups:
+    addGroup(group.first, group.second, group.second.own_thread && command_group_);
+  }
+
   velocity_hs_ = std::make_shared<velocity_topic_container>();
   lock_hs_ = std::make_shared<lock_topic_container>();
-  getTopicHandles("topics", *velocity_hs_);
-  getTopicHandles("locks", *lock_hs_);
-  
+  for (const auto & config : velocities) {
+    velocity_hs_->push_back(createVelocityHandle(config));
+  }
+  for (const auto & config : locks) {
+    lock_hs_->push_back(createLockHandle(config));
+  }
+  velocity_by_id_ = indexVelocities(*velocity_hs_);
+
+  /// Fail-safe on expiry of the active source:
+  std::vector<double> failsafe_linear, failsafe_angular;
+  fetch_param_or(nh, "failsafe.enabled", failsafe_enabled_, false);
+  fetch_param_or(nh, "failsafe.linear", failsafe_linear, std::vector<double>{0.0, 0.0, 0.0});
+  fetch_param_or(nh, "failsafe.angular", failsafe_angular, std::vector<double>{0.0, 0.0, 0.0});
+  if (failsafe_linear.size() != 3 || failsafe_angular.size() != 3) {
+    RCLCPP_FATAL(get_logger(), "failsafe.linear and failsafe.angular must have 3 elements.");
+    throw ParamsHelperException("invalid fail-safe twist");
+  }
+  failsafe_cmd_.twist.linear.x = failsafe_linear[0];
+  failsafe_cmd_.twist.linear.y = failsafe_linear[1];
+  failsafe_cmd_.twist.linear.z = failsafe_linear[2];
+  failsafe_cmd_.twist.angular.x = failsafe_angular[0];
+  failsafe_cmd_.twist.angular.y = failsafe_angular[1];
+  failsafe_cmd_.twist.angular.z = failsafe_angular[2];
+
   try {
     output_stamped = get_parameter("output_stamped").as_bool();
   } catch (const rclcpp::exceptions::ParameterNotDeclaredException& e)
@@ -91,167 +297,997 @@ void TwistMux::init()
   }
 
   /// Publisher for output topic:
+  rclcpp::QoS output_qos(rclcpp::KeepLast(1));
+  try {
+    fetch_qos(nh, "output.qos", output_qos);
+  } catch (const ParamsHelperException & e) {
+    RCLCPP_FATAL(get_logger(), "Error parsing params 'output.qos':\n\t%s", e.what());
+    throw e;
+  }
+
   if (output_stamped) {
-      cmd_pub_ = this->create_publisher<geometry_msgs::msg::TwistStamped>(
-          "cmd_vel_out", rclcpp::QoS(rclcpp::KeepLast(1)));
+    output_ = std::make_unique<TwistOutput<geometry_msgs::msg::TwistStamped>>(
+      this, "cmd_vel_out", output_qos, memory_pool);
   } else {
-      cmd_pub_ = this->create_publisher<geometry_msgs::msg::Twist>(
-          "cmd_vel_out", rclcpp::QoS(rclcpp::KeepLast(1)));
+    output_ = std::make_unique<TwistOutput<geometry_msgs::msg::Twist>>(
+      this, "cmd_vel_out", output_qos, memory_pool);
   }
-  
+
   /// Diagnostics:
-  diagnostics_ = std::make_shared<diagnostics_type>(this);
+  diagnostics_ = std::make_shared<diagnostics_type>(this, host_diagnostics_);
   status_ = std::make_shared<status_type>();
   status_->velocity_hs = velocity_hs_;
   status_->lock_hs = lock_hs_;
 
-  diagnostics_timer_ = this->create_wall_timer(
-    DIAGNOSTICS_PERIOD, [this]() -> void {
-      updateDiagnostics();
+  if (!host_diagnostics_) {
+    diagnostics_timer_ = this->create_wall_timer(
+      DIAGNOSTICS_PERIOD, [this]() -> void {
+        updateDiagnostics();
+      });
+  }
+
+  /// Output scheduling:
+  double output_rate = 0.0;
+  double output_max_rate = 0.0;
+  fetch_param_or(nh, "output.rate", output_rate, 0.0);
+  fetch_param_or(nh, "output.max_rate", output_max_rate, 0.0);
+  fetch_param_or(nh, "output.deduplicate", deduplicate_output_, false);
+  if (output_max_rate > 0.0) {
+    min_output_interval_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(1.0 / output_max_rate));
+  }
+
+  /// Output smoothing:
+  bool smoothing = false;
+  double lock_transition_time = 0.0;
+  fetch_param_or(nh, "smoothing.enabled", smoothing, false);
+  fetch_param_or(nh, "smoothing.lock_transition_time", lock_transition_time, 0.0);
+  if (smoothing) {
+    auto fetch_axes = [&nh, this](const std::string & name) {
+        std::vector<double> linear, angular;
+        fetch_param_or(nh, name + ".linear", linear, std::vector<double>{0.0, 0.0, 0.0});
+        fetch_param_or(nh, name + ".angular", angular, std::vector<double>{0.0, 0.0, 0.0});
+        if (linear.size() != 3 || angular.size() != 3) {
+          RCLCPP_FATAL(get_logger(), "%s.linear and .angular must have 3 elements.", name.c_str());
+          throw ParamsHelperException("invalid smoothing limits");
+        }
+        return VelocityLimiter::axes_type{
+          linear[0], linear[1], linear[2], angular[0], angular[1], angular[2]};
+      };
+
+    limiter_ = std::make_unique<VelocityLimiter>(
+      fetch_axes("smoothing.max_acceleration"), fetch_axes("smoothing.max_jerk"));
+    lock_transition_time_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(lock_transition_time));
+  }
+
+  if (output_rate > 0.0) {
+    fixed_rate_output_ = true;
+    output_timer_ = this->create_wall_timer(
+      std::chrono::duration<double>(1.0 / output_rate), [this]() -> void {
+        {
+          std::lock_guard<std::mutex> lock(arbitration_mutex_);
+          updateExpiry();
+          publishWinner();
+        }
+        flushOutput();
+      }, command_group_);
+  }
+
+  /// Deadlines:
+  if (!host_diagnostics_) {
+    expiry_timer_ = this->create_wall_timer(
+      EXPIRY_CHECK_PERIOD, [this]() -> void {
+        checkExpiry();
+      }, command_group_);
+  }
+
+  /// Statistics topic:
+  double statistics_rate = 0.0;
+  fetch_param_or(nh, "statistics.rate", statistics_rate, 0.0);
+  if (statistics_rate > 0.0) {
+    initStatistics(statistics_rate);
+  }
+
+  initReady();
+
+  active_source_pub_ = create_publisher<msg::ActiveSource>(
+    "~/active_source", rclcpp::QoS(rclcpp::KeepLast(1)).reliable().transient_local());
+  {
+    std::lock_guard<std::mutex> lock(arbitration_mutex_);
+    // The locks start expired, which is no transition:
+    output_lock_priority_ = arbitration_.getLockPriority();
+    updateActiveSource();
+  }
+
+  /// Reconfiguration, in the default callback group like the diagnostics:
+  reconfigure_timer_ = create_wall_timer(
+    RECONFIGURE_DELAY, [this]() -> void {
+      reconfigure_timer_->cancel();
+      reconfigure();
+    });
+  reconfigure_timer_->cancel();
+
+  parameters_callback_ = add_on_set_parameters_callback(
+    [this](const std::vector<rclcpp::Parameter> & parameters) {
+      rcl_interfaces::msg::SetParametersResult result;
+      result.successful = true;
+
+      for (const auto & parameter : parameters) {
+        const auto & name = parameter.get_name();
+        if (name.rfind("topics.", 0) == 0 || name.rfind("locks.", 0) == 0 ||
+        name.rfind("groups.", 0) == 0)
+        {
+          if (compiled_configuration_) {
+            result.successful = false;
+            result.reason = "the configuration is compiled in";
+            break;
+          }
+
+          // The parameters are only set once this callback returns:
+          reconfigure_timer_->reset();
+          break;
+        }
+      }
+
+      return result;
+    });
+}
+
+void TwistMux::initReady()
+{
+  ready_pub_ = create_publisher<std_msgs::msg::Bool>(
+    "~/ready", rclcpp::QoS(rclcpp::KeepLast(1)).reliable().transient_local());
+
+  std_msgs::msg::Bool ready;
+  ready.data = false;
+  ready_pub_->publish(ready);
+
+  ready_timer_ = create_wall_timer(
+    READY_CHECK_PERIOD, [this]() -> void {
+      updateReady();
     });
 }
 
+void TwistMux::updateReady()
+{
+  for (const auto & velocity_h : *velocity_hs_) {
+    if (velocity_h->getPublisherCount() == 0) {
+      return;
+    }
+  }
+  for (const auto & lock_h : *lock_hs_) {
+    if (lock_h->getPublisherCount() == 0) {
+      return;
+    }
+  }
+
+  ready_timer_->cancel();
+  ready_ = true;
+
+  std_msgs::msg::Bool ready;
+  ready.data = true;
+  ready_pub_->publish(ready);
+
+  RCLCPP_INFO(
+    get_logger(), "Ready: %zu velocity and %zu lock topics matched after %.1fms",
+    velocity_hs_->size(), lock_hs_->size(),
+    std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start_time_).count());
+}
+
+void TwistMux::initStatistics(double rate)
+{
+  sources_pub_ = create_publisher<msg::TwistMuxSources>(
+    "~/statistics/sources", rclcpp::QoS(rclcpp::KeepLast(1)).transient_local());
+  publishSources();
+
+  statistics_msg_.velocities.resize(velocity_hs_->size());
+  statistics_msg_.locks.resize(lock_hs_->size());
+  statistics_pub_ = create_publisher<msg::TwistMuxStatistics>(
+    "~/statistics", rclcpp::QoS(rclcpp::KeepLast(1)));
+
+  statistics_timer_ = create_wall_timer(
+    std::chrono::duration<double>(1.0 / rate), [this]() -> void {
+      publishStatistics();
+    });
+}
+
+void TwistMux::publishSources()
+{
+  msg::TwistMuxSources sources;
+  for (const auto & velocity_h : *velocity_hs_) {
+    sources.velocities.push_back(
+      velocity_h->getName());
+  }
+  for (const auto & lock_h : *lock_hs_) {
+    sources.locks.push_back(lock_h->getName());
+  }
+
+  sources_pub_->publish(sources);
+}
+
+void TwistMux::publishStatistics()
+{
+  {
+    std::lock_guard<std::mutex> lock(arbitration_mutex_);
+
+    const auto stamp = now();
+    const auto time = stamp.nanoseconds();
+    const auto winner = arbitration_.getWinner();
+
+    auto fill = [this, time](const auto & handle, msg::SourceStatistics & statistics) {
+        const auto id = handle.getId();
+        statistics.received = handle.getReceived();
+        statistics.forwarded = handle.getForwarded();
+        statistics.lost = handle.getLost();
+        statistics.interval = handle.getInterval();
+        statistics.jitter = handle.getJitter();
+        statistics.time_masked = arbitration_.getMaskedTime(id, time);
+        statistics.time_winner = arbitration_.getWinnerTime(id, time);
+        statistics.priority = static_cast<std::uint8_t>(handle.getPriority());
+      };
+
+    statistics_msg_.stamp = stamp;
+    statistics_msg_.winner_switches = arbitration_.getWinnerSwitches();
+    statistics_msg_.winner = -1;
+
+    for (std::size_t i = 0; i < velocity_hs_->size(); ++i) {
+      const auto & handle = *(*velocity_hs_)[i];
+      auto & statistics = statistics_msg_.velocities[i];
+      fill(handle, statistics);
+      statistics.masked = handle.isMasked();
+      if (handle.getId() == winner) {
+        statistics_msg_.winner = static_cast<std::int32_t>(i);
+      }
+    }
+
+    for (std::size_t i = 0; i < lock_hs_->size(); ++i) {
+      auto & statistics = statistics_msg_.locks[i];
+      fill(*(*lock_hs_)[i], statistics);
+      statistics.masked = (*lock_hs_)[i]->isLocked();
+    }
+  }
+
+  // Only this timer writes the message:
+  statistics_pub_->publish(statistics_msg_);
+}
+
+void TwistMux::expire(ArbitrationEngine::handle_id id)
+{
+  {
+    std::lock_guard<std::mutex> lock(arbitration_mutex_);
+
+    const auto stamp = now().nanoseconds();
+    arbitration_.expireNow(id, stamp);
+    handover(stamp);
+    updateLock();
+    updateActiveSource();
+  }
+  flushOutput();
+}
+
+void TwistMux::updateActiveSource()
+{
+  const auto winner = arbitration_.getWinner();
+  const auto lock_priority = arbitration_.getLockPriority();
+  if (winner == active_source_winner_ && lock_priority == active_source_lock_priority_) {
+    return;
+  }
+  active_source_winner_ = winner;
+  active_source_lock_priority_ = lock_priority;
+
+  active_source_msg_.stamp = now();
+  active_source_msg_.name.clear();
+  active_source_msg_.id = -1;
+  active_source_msg_.priority = 0;
+  active_source_msg_.lock_priority = static_cast<std::uint8_t>(lock_priority);
+
+  // Only on a change, so the index is searched for, as for the statistics:
+  for (std::size_t i = 0; i < velocity_hs_->size(); ++i) {
+    const auto & handle = *(*velocity_hs_)[i];
+    if (handle.getId() == winner) {
+      active_source_msg_.name = handle.getName();
+      active_source_msg_.id = static_cast<std::int32_t>(i);
+      active_source_msg_.priority = static_cast<std::uint8_t>(arbitration_.getTopPriority(winner));
+      break;
+    }
+  }
+
+  active_source_pub_->publish(active_source_msg_);
+}
+
+void TwistMux::updateLock()
+{
+  const auto lock_priority = arbitration_.getLockPriority();
+  if (lock_priority == output_lock_priority_) {
+    return;
+  }
+
+  // The sources a lock releases ramp from the current output:
+  if (limiter_ && lock_priority < output_lock_priority_) {
+    limiter_->reset();
+  }
+  output_lock_priority_ = lock_priority;
+
+  // A lock below the winner changes nothing:
+  const auto winner = arbitration_.getWinner();
+  if (winner == active_) {
+    return;
+  }
+  active_ = winner;
+
+  // Published at once, even at a fixed output rate, whose timer might be a
+  // period away:
+  const auto winner_h = getVelocityHandle(winner);
+  const auto command = winner_h ? winner_h->getCommand() : nullptr;
+  if (command) {
+    publishOutput(*command);
+    return;
+  }
+
+  // The stop bypasses the rate limit, since with no winner the next tick
+  // would have nothing to publish and the output would keep moving, and the
+  // smoothing, so the lock stops at once:
+  if (limiter_) {
+    limiter_->reset();
+  }
+  emitOutput(stop_command_, true, std::chrono::steady_clock::now(), false);
+}
+
+void TwistMux::checkExpiry()
+{
+  {
+    std::lock_guard<std::mutex> lock(arbitration_mutex_);
+    updateExpiry();
+
+    // A command held back by the rate limit, or limited by the smoothing:
+    if (output_pending_) {
+      publishWinner();
+    }
+
+    updateMirror();
+  }
+  flushOutput();
+}
+
+void TwistMux::updateExpiry()
+{
+  const auto stamp = now().nanoseconds();
+
+  // Most of the time nothing is due, which is a single compare:
+  if (arbitration_.nextDeadline() < stamp) {
+    arbitration_.update(stamp);
+    handover(stamp);
+    updateLock();
+    updateActiveSource();
+  }
+}
+
+void TwistMux::handover(ArbitrationEngine::time_type stamp)
+{
+  if (!failsafe_enabled_ || active_ == ArbitrationEngine::NO_HANDLE ||
+    !arbitration_.hasExpired(active_))
+  {
+    return;
+  }
+
+  // Only an expiry is measured: a source removed by a reconfiguration, or
+  // re-added under a new id, hands over before its deadline:
+  const auto deadline = arbitration_.getDeadline(active_);
+  if (getVelocityHandle(active_) && deadline != ArbitrationEngine::NEVER && deadline <= stamp) {
+    handover_latency_ = 1e-9 * static_cast<double>(stamp - deadline);
+    max_handover_latency_ = std::max(max_handover_latency_, handover_latency_);
+  }
+
+  active_ = arbitration_.getWinner();
+
+  // The new source ramps from the current output, not from the acceleration
+  // of the previous one:
+  if (limiter_) {
+    limiter_->reset();
+  }
+
+  const auto winner_h = getVelocityHandle(active_);
+  if (winner_h) {
+    // Note that a winner without timeout might not have received anything:
+    const auto command = winner_h->getCommand();
+    publishTwist(command ? *command : failsafe_command_, !command);
+  } else {
+    publishTwist(failsafe_command_, true);
+  }
+}
+
 void TwistMux::updateDiagnostics()
 {
-  status_->priority = getLockPriority();
+  std::lock_guard<std::mutex> reconfigure_lock(reconfigure_mutex_);
+  {
+    // Snapshot, so the diagnostics never read the state the command
+    // callbacks are writing:
+    std::lock_guard<std::mutex> lock(arbitration_mutex_);
+    updateExpiry();
+
+    status_->priority = getLockPriority();
+    // The engine is only copied when the state it reports has changed:
+    if (status_->arbitration.getStateVersion() != arbitration_.getStateVersion()) {
+      status_->arbitration = arbitration_;
+      // The copy is read by the diagnostics only, which must not record:
+      status_->arbitration.setRecorder(nullptr);
+    }
+    status_->winner_switches = arbitration_.getWinnerSwitches();
+    status_->handover_latency = handover_latency_;
+    status_->max_handover_latency = max_handover_latency_;
+
+    for (const auto & velocity_h : *velocity_hs_) {
+      velocity_h->updateMasked();
+    }
+  }
+  // The expiry might have staged a command:
+  flushOutput();
+
+  // Only the reconfiguration replaces the handles:
+  for (const auto & velocity_h : *velocity_hs_) {
+    velocity_h->updateSubscription();
+  }
+
+  // The statistics are lock-free, so they are collected without blocking
+  // the command callbacks:
+  updateStatistics();
+
   diagnostics_->updateStatus(status_);
 }
 
-template <typename MessageConstSharedPtrT>
-void TwistMux::publishTwist(const MessageConstSharedPtrT & msg)
-{
-  std::visit([&msg, this](auto&& pub) {
-    /*
-    There are four possible combinations:
-        In   ->    Out
-    1. TwistStamped -> TwistStamped
-    2. TwistStamped -> Twist
-    3. Twist -> TwistStamped
-    4. Twist -> Twist
-    */
-
-    // Decide based on output_stamped at runtime
-    if (output_stamped) {
-      if (auto twist_stamped_pub = std::dynamic_pointer_cast<rclcpp::Publisher<geometry_msgs::msg::TwistStamped>>(pub)) {
-        // If we have a TwistStamped publisher and the output needs to be TwistStamped
-        if constexpr (std::is_same_v<std::decay_t<MessageConstSharedPtrT>, geometry_msgs::msg::TwistStamped::ConstSharedPtr>) {
-          twist_stamped_pub->publish(*msg);  // Publish TwistStamped directly
-        } else if constexpr (std::is_same_v<std::decay_t<MessageConstSharedPtrT>, geometry_msgs::msg::Twist::ConstSharedPtr>) {
-          geometry_msgs::msg::TwistStamped twist_stamped_msg;
-          twist_stamped_msg.twist = *msg;  // Wrap Twist in TwistStamped
-          twist_stamped_pub->publish(twist_stamped_msg);  // Publish the wrapped message
-        }
-      } else {
-        RCLCPP_FATAL(get_logger(), "Expected TwistStamped publisher, but received different type.");
+void TwistMux::updateStatistics()
+{
+  const auto stamp = rclcpp::Clock().now();
+  const double period = (stamp - status_->last_loop_update).seconds();
+  status_->last_loop_update = stamp;
+
+  status_->callback_latency = callback_latency_.collect();
+  status_->main_loop_time = 1e-9 * static_cast<double>(status_->callback_latency.max);
+
+  auto update = [period](auto & handle, status_type::SourceStatistics & statistics) {
+      const auto received = handle.getReceived();
+      statistics.rate = (period > 0) ?
+        static_cast<double>(received - statistics.received) / period : 0.0;
+      statistics.received = received;
+      statistics.age = 1e-9 * static_cast<double>(handle.getAge().collect().max);
+    };
+
+  status_->velocity_statistics.resize(velocity_hs_->size());
+  status_->lock_statistics.resize(lock_hs_->size());
+
+  status_->reading_age = 0;
+  for (std::size_t i = 0; i < velocity_hs_->size(); ++i) {
+    update(*(*velocity_hs_)[i], status_->velocity_statistics[i]);
+    status_->reading_age = std::max(status_->reading_age, status_->velocity_statistics[i].age);
+  }
+  for (std::size_t i = 0; i < lock_hs_->size(); ++i) {
+    update(*(*lock_hs_)[i], status_->lock_statistics[i]);
+  }
+}
+
+void TwistMux::publishTwist(const VelocityCommand & command, bool stop)
+{
+  // The winner message is already stored in its handle for the timer:
+  if (fixed_rate_output_) {
+    return;
+  }
+
+  publishOutput(command, stop);
+}
+
+void TwistMux::publishOutput(const VelocityCommand & command, bool stop)
+{
+  const bool timed = min_output_interval_.count() > 0 || limiter_;
+  const auto now = timed ?
+    std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+  if (min_output_interval_.count() > 0 && has_output_ &&
+    now - last_output_time_ < min_output_interval_)
+  {
+    output_pending_ = true;
+    return;
+  }
+
+  emitOutput(command, stop, now);
+}
+
+void TwistMux::emitOutput(
+  const VelocityCommand & command, bool stop,
+  std::chrono::steady_clock::time_point now, bool smoothing)
+{
+  // The only copy of the command, straight into the message published; the
+  // smoothing and the deduplication work on it in place:
+  auto & twist = output_->prepare(command);
+  output_pending_ = limiter_ && smoothing && smooth(twist, now, stop);
+
+  // A duplicate is prepared again by the next command:
+  if (deduplicate_output_ && has_output_ && twist == getLastTwist()) {
+    return;
+  }
+
+  has_output_ = true;
+  last_output_time_ = now;
+  if (recorder_) {
+    recorder_->record(
+      EventRecorder::PUBLISH, this->now().nanoseconds(),
+      arbitration_.getWinner() == ArbitrationEngine::NO_HANDLE ?
+      EventRecorder::NO_ID : static_cast<std::uint32_t>(arbitration_.getWinner()),
+      0, 0, output_pending_);
+  }
+  if (deduplicate_output_ || limiter_) {
+    last_twist_ = twist;
+  }
+
+  // Published by flushOutput() once the arbitration mutex is released:
+  output_->stage();
+
+  if (status_mirror_) {
+    mirror_status_.linear[0] = twist.linear.x;
+    mirror_status_.linear[1] = twist.linear.y;
+    mirror_status_.linear[2] = twist.linear.z;
+    mirror_status_.angular[0] = twist.angular.x;
+    mirror_status_.angular[1] = twist.angular.y;
+    mirror_status_.angular[2] = twist.angular.z;
+    updateMirror();
+  }
+}
+
+void TwistMux::flushOutput()
+{
+  output_->flush();
+}
+
+void TwistMux::updateMirror()
+{
+  if (!status_mirror_) {
+    return;
+  }
+
+  // The position of the winner, as in ~/active_source, is only searched for
+  // when it changes:
+  const auto winner = arbitration_.getWinner();
+  if (winner != mirror_winner_) {
+    mirror_winner_ = winner;
+    mirror_status_.winner = StatusMirror::NO_ID;
+    for (std::size_t i = 0; i < velocity_hs_->size(); ++i) {
+      if ((*velocity_hs_)[i]->getId() == winner) {
+        mirror_status_.winner = static_cast<std::uint32_t>(i);
+        break;
       }
+    }
+  }
+  mirror_status_.lock_priority = arbitration_.getLockPriority();
+  status_mirror_->update(mirror_status_);
+}
+
+bool TwistMux::smooth(
+  geometry_msgs::msg::Twist & twist, std::chrono::steady_clock::time_point now, bool stop)
+{
+  const auto & last = getLastTwist();
+
+  const auto lock_priority = arbitration_.getLockPriority();
+  const bool lock_changed = lock_priority != last_lock_priority_;
+  if (lock_changed) {
+    last_lock_priority_ = lock_priority;
+    lock_transition_end_ = now + lock_transition_time_;
+  }
+
+  // While a lock engages or releases the command can only decrease:
+  bool held = false;
+  if (has_output_ && now < lock_transition_end_ && hasIncreasedAbsVelocity(last, twist)) {
+    twist = last;
+    held = true;
+  }
+
+  // The first command ramps from a standstill:
+  const double dt = has_output_ ?
+    std::chrono::duration<double>(now - last_output_time_).count() :
+    std::chrono::duration<double>(EXPIRY_CHECK_PERIOD).count();
+
+  // A stop, or a lock engaging or releasing, only slows down at once:
+  const bool brake = stop || lock_changed || now < lock_transition_end_;
+  return limiter_->limit(twist, last, dt, brake) || held;
+}
+
+const geometry_msgs::msg::Twist & TwistMux::getLastTwist() const
+{
+  return last_twist_;
+}
+
+void TwistMux::publishWinner()
+{
+  const auto winner_h = getVelocityHandle(arbitration_.getWinner());
+  if (!winner_h) {
+    if (failsafe_enabled_) {
+      publishOutput(failsafe_command_, true);
     } else {
-      if (auto twist_pub = std::dynamic_pointer_cast<rclcpp::Publisher<geometry_msgs::msg::Twist>>(pub)) {
-        // If we have a Twist publisher and the output needs to be Twist
-        if constexpr (std::is_same_v<std::decay_t<MessageConstSharedPtrT>, geometry_msgs::msg::TwistStamped::ConstSharedPtr>) {
-          twist_pub->publish(msg->twist);  // Extract Twist from TwistStamped and publish
-        } else if constexpr (std::is_same_v<std::decay_t<MessageConstSharedPtrT>, geometry_msgs::msg::Twist::ConstSharedPtr>) {
-          twist_pub->publish(*msg);  // Publish Twist directly
-        }
-      } else {
-        RCLCPP_FATAL(get_logger(), "Expected Twist publisher, but received different type.");
+      output_pending_ = false;
+    }
+    return;
+  }
+
+  // Note that a winner without timeout might not have received anything:
+  const auto command = winner_h->getCommand();
+  if (command) {
+    publishOutput(*command);
+  } else if (failsafe_enabled_) {
+    publishOutput(failsafe_command_, true);
+  } else {
+    output_pending_ = false;
+  }
+}
+
+TwistMux::Configuration TwistMux::readConfiguration()
+{
+  Configuration configuration;
+  configuration.groups = readGroups("groups");
+  configuration.velocities = readTopics("topics", true, configuration.groups);
+  configuration.locks = readTopics("locks", false, configuration.groups);
+  return configuration;
+}
+
+void TwistMux::validate(const Configuration & configuration)
+{
+  for (const auto & config : configuration.velocities) {
+    validateTopic(config, configuration.groups);
+  }
+
+  // The names select the handles kept by a reconfiguration, as the
+  // parameter prefixes they stand for:
+  std::set<std::string> names;
+  for (const auto * configs : {&configuration.velocities, &configuration.locks}) {
+    for (const auto & config : *configs) {
+      if (config.topic.empty()) {
+        throw ParamsHelperException("no topic for " + config.name);
+      }
+      if (!names.insert(config.name).second) {
+        throw ParamsHelperException("duplicate handle " + config.name);
       }
     }
-  }, cmd_pub_);
+  }
 }
 
+void TwistMux::validateTopic(const TopicConfig & config, const group_config_map & groups)
+{
+  if (velocityInputs().find(config.type) == velocityInputs().end()) {
+    throw ParamsHelperException("unknown type '" + config.type + "' for " + config.name);
+  }
+  if (!config.group.empty() && groups.find(config.group) == groups.end()) {
+    throw ParamsHelperException("unknown group '" + config.group + "' for " + config.name);
+  }
+}
 
-template<typename T>
-void TwistMux::getTopicHandles(const std::string & param_name, std::list<T> & topic_hs)
+TwistMux::group_config_map TwistMux::readGroups(const std::string & param_name)
 {
-  RCLCPP_DEBUG(get_logger(), "getTopicHandles: %s", param_name.c_str());
+  rcl_interfaces::msg::ListParametersResult list = list_parameters({param_name}, 10);
+  auto nh = std::shared_ptr<rclcpp::Node>(this, [](rclcpp::Node *) {});
+
+  group_config_map groups;
+  try {
+    for (const auto & prefix : childPrefixes(list, param_name)) {
+      GroupConfig config{0, false};
+
+      fetch_param(nh, prefix + ".priority", config.priority);
+      fetch_param_or(nh, prefix + ".own_thread", config.own_thread, false);
+
+      groups[prefix.substr(param_name.size() + 1)] = config;
+    }
+  } catch (const ParamsHelperException & e) {
+    RCLCPP_FATAL(get_logger(), "Error parsing params '%s':\n\t%s", param_name.c_str(), e.what());
+    throw e;
+  }
+
+  return groups;
+}
+
+std::vector<TwistMux::TopicConfig> TwistMux::readTopics(
+  const std::string & param_name,
+  bool velocity, const group_config_map & groups)
+{
+  RCLCPP_DEBUG(get_logger(), "readTopics: %s", param_name.c_str());
 
   rcl_interfaces::msg::ListParametersResult list = list_parameters({param_name}, 10);
+  auto nh = std::shared_ptr<rclcpp::Node>(this, [](rclcpp::Node *) {});
 
+  const auto prefixes = childPrefixes(list, param_name);
+  std::vector<TopicConfig> topics;
+  topics.reserve(prefixes.size());
   try {
-    for (auto prefix : list.prefixes) {
+    for (const auto & prefix : prefixes) {
       RCLCPP_DEBUG(get_logger(), "Prefix: %s", prefix.c_str());
 
-      std::string topic;
-      double timeout = 0;
-      int priority = 0;
-      bool stamped = false;
-
-      auto nh = std::shared_ptr<rclcpp::Node>(this, [](rclcpp::Node *) {});
-
-      fetch_param(nh, prefix + ".topic", topic);
-      fetch_param(nh, prefix + ".timeout", timeout);
-      fetch_param(nh, prefix + ".priority", priority);
-
-      RCLCPP_DEBUG(get_logger(), "Retrieved topic: %s", topic.c_str());
-      RCLCPP_DEBUG(get_logger(), "Listed prefix: %.2f", timeout);
-      RCLCPP_DEBUG(get_logger(), "Listed prefix: %d", priority);
-      
-      if constexpr (std::is_same_v<T, velocity_handle_variant>){
-        try {
-          fetch_param(nh, prefix + ".stamped", stamped);
-        } catch (const ParamsHelperException& e) {
-          RCLCPP_WARN(get_logger(), ".stamped is not defined, false is assumed.");
+      TopicConfig config{prefix, "", 0, 0, "", "", rclcpp::SystemDefaultsQoS(), std::nullopt};
+
+      fetch_param(nh, prefix + ".topic", config.topic);
+      fetch_param(nh, prefix + ".timeout", config.timeout);
+      fetch_param(nh, prefix + ".priority", config.priority);
+
+      RCLCPP_DEBUG(get_logger(), "Retrieved topic: %s", config.topic.c_str());
+      RCLCPP_DEBUG(get_logger(), "Listed prefix: %.2f", config.timeout);
+      RCLCPP_DEBUG(get_logger(), "Listed prefix: %d", config.priority);
+
+      fetch_qos(nh, prefix + ".qos", config.qos);
+
+      if (velocity) {
+        // The type, or else the stamped flag, selects the input type:
+        fetch_param_or(nh, prefix + ".type", config.type, std::string());
+        if (config.type.empty()) {
+          bool stamped = false;
+          try {
+            fetch_param(nh, prefix + ".stamped", stamped);
+          } catch (const ParamsHelperException& e) {
+            RCLCPP_WARN(get_logger(), ".stamped is not defined, false is assumed.");
+          }
+          config.type = stamped ?
+            VelocityInputTraits<geometry_msgs::msg::TwistStamped>::type :
+            VelocityInputTraits<geometry_msgs::msg::Twist>::type;
         }
-        if(stamped) {
-          topic_hs.emplace_back(std::in_place_type<VelocityTopicHandle<geometry_msgs::msg::TwistStamped>>,
-                                prefix, topic, std::chrono::duration<double>(timeout), priority, this);
-        } else {
-          topic_hs.emplace_back(std::in_place_type<VelocityTopicHandle<geometry_msgs::msg::Twist>>,
-                              prefix, topic, std::chrono::duration<double>(timeout), priority, this);
+        fetch_param_or(nh, prefix + ".group", config.group, std::string());
+        validateTopic(config, groups);
+
+        // A masked source only needs its last message, so by default its
+        // subscription keeps just that one, without retransmits:
+        bool masked_qos = false;
+        fetch_param_or(nh, prefix + ".masked_qos.enabled", masked_qos, false);
+        if (masked_qos) {
+          config.masked_qos = rclcpp::QoS(config.qos).keep_last(1).best_effort();
+          fetch_qos(nh, prefix + ".masked_qos", *config.masked_qos);
         }
-      } else {
-          topic_hs.emplace_back(prefix, topic, std::chrono::duration<double>(timeout), priority, this);
       }
+
+      topics.push_back(config);
     }
   } catch (const ParamsHelperException & e) {
     RCLCPP_FATAL(get_logger(), "Error parsing params '%s':\n\t%s", param_name.c_str(), e.what());
     throw e;
   }
+
+  return topics;
 }
 
-int TwistMux::getLockPriority()
+void TwistMux::addGroup(const std::string & name, const GroupConfig & config, bool own_thread)
 {
-  LockTopicHandle::priority_type priority = 0;
+  {
+    std::lock_guard<std::mutex> lock(arbitration_mutex_);
+    group_ids_[name] = arbitration_.addGroup(config.priority);
+  }
 
-  /// max_element on the priority of lock topic handles satisfying
-  /// that is locked:
-  for (const auto & lock_h : *lock_hs_) {
-    if (lock_h.isLocked()) {
-      auto tmp = lock_h.getPriority();
-      if (priority < tmp) {
-        priority = tmp;
+  group_callback_groups_.push_back(
+    own_thread ? create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive) : nullptr);
+
+  RCLCPP_DEBUG(get_logger(), "Group %s with priority %d", name.c_str(), config.priority);
+}
+
+std::shared_ptr<VelocityTopicHandle> TwistMux::createVelocityHandle(const TopicConfig & config)
+{
+  const auto group = config.group.empty() ?
+    ArbitrationEngine::NO_GROUP : group_ids_.at(config.group);
+
+  auto handle = velocityInputs().at(config.type)(
+    config.name, config.topic, std::chrono::duration<double>(config.timeout), config.priority,
+    this, group, config.qos);
+  handle->setMaskedQoS(config.masked_qos);
+  return handle;
+}
+
+std::shared_ptr<LockTopicHandle> TwistMux::createLockHandle(const TopicConfig & config)
+{
+  return std::make_shared<LockTopicHandle>(
+    config.name, config.topic, std::chrono::duration<double>(config.timeout), config.priority,
+    this, config.qos);
+}
+
+std::vector<VelocityTopicHandle *> TwistMux::indexVelocities(
+  const velocity_topic_container & velocity_hs)
+{
+  ArbitrationEngine::handle_id size = 0;
+  for (const auto & velocity_h : velocity_hs) {
+    size = std::max(size, velocity_h->getId() + 1);
+  }
+
+  std::vector<VelocityTopicHandle *> velocity_by_id(size, nullptr);
+  for (const auto & velocity_h : velocity_hs) {
+    velocity_by_id[velocity_h->getId()] = velocity_h.get();
+  }
+  return velocity_by_id;
+}
+
+void TwistMux::reconfigure()
+{
+  std::lock_guard<std::mutex> reconfigure_lock(reconfigure_mutex_);
+
+  /// Everything is read first, so an invalid configuration changes nothing:
+  Configuration configuration;
+  try {
+    configuration = readConfiguration();
+  } catch (const ParamsHelperException & e) {
+    RCLCPP_ERROR(get_logger(), "Invalid configuration, keeping the current one: %s", e.what());
+    return;
+  }
+  const auto & groups = configuration.groups;
+  const auto & velocities = configuration.velocities;
+  const auto & locks = configuration.locks;
+
+  // The new groups have no thread of their own, as the executors are set up:
+  for (const auto & group : groups) {
+    if (group_ids_.find(group.first) == group_ids_.end()) {
+      addGroup(group.first, group.second, false);
+    }
+  }
+
+  auto same_handle = [](const TopicConfig & config, const auto & handle) {
+      return config.topic == handle.getTopic() && config.qos == handle.getQoS();
+    };
+
+  /// The new handles subscribe before the swap, without blocking the
+  /// callbacks, so the kept handles never miss a message:
+  auto velocity_hs = std::make_shared<velocity_topic_container>();
+  std::vector<bool> kept_velocities(velocity_hs_->size(), false);
+  for (const auto & config : velocities) {
+    const auto group = config.group.empty() ?
+      ArbitrationEngine::NO_GROUP : group_ids_.at(config.group);
+
+    std::shared_ptr<VelocityTopicHandle> kept;
+    for (std::size_t i = 0; i < velocity_hs_->size() && !kept; ++i) {
+      const auto & handle = *(*velocity_hs_)[i];
+      if (!kept_velocities[i] && handle.getName() == config.name &&
+        same_handle(config, handle) && handle.getType() == config.type &&
+        config.masked_qos == handle.getMaskedQoS() &&
+        arbitration_.getGroup(handle.getId()) == group)
+      {
+        kept = (*velocity_hs_)[i];
+        kept_velocities[i] = true;
       }
     }
+    velocity_hs->push_back(kept ? kept : createVelocityHandle(config));
   }
 
-  RCLCPP_DEBUG(get_logger(), "Priority = %d.", static_cast<int>(priority));
+  auto lock_hs = std::make_shared<lock_topic_container>();
+  std::vector<bool> kept_locks(lock_hs_->size(), false);
+  for (const auto & config : locks) {
+    std::shared_ptr<LockTopicHandle> kept;
+    for (std::size_t i = 0; i < lock_hs_->size() && !kept; ++i) {
+      const auto & handle = *(*lock_hs_)[i];
+      if (!kept_locks[i] && handle.getName() == config.name && same_handle(config, handle)) {
+        kept = (*lock_hs_)[i];
+        kept_locks[i] = true;
+      }
+    }
+    lock_hs->push_back(kept ? kept : createLockHandle(config));
+  }
 
-  return priority;
+  // Released here, a full reconfiguration after their removal:
+  retired_velocity_hs_.clear();
+  retired_lock_hs_.clear();
+
+  // Whatever allocates is built before the lock, which is only held for the
+  // updates of the arbitration and the swaps:
+  auto velocity_by_id = indexVelocities(*velocity_hs);
+  std::vector<msg::SourceStatistics> velocity_statistics(velocity_hs->size());
+  std::vector<msg::SourceStatistics> lock_statistics(lock_hs->size());
+  for (std::size_t i = 0; i < velocity_hs_->size(); ++i) {
+    if (!kept_velocities[i]) {
+      retired_velocity_hs_.push_back((*velocity_hs_)[i]);
+    }
+  }
+  for (std::size_t i = 0; i < lock_hs_->size(); ++i) {
+    if (!kept_locks[i]) {
+      retired_lock_hs_.push_back((*lock_hs_)[i]);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(arbitration_mutex_);
+    const auto stamp = now();
+
+    for (const auto & group : groups) {
+      arbitration_.setGroupPriority(
+        group_ids_.at(group.first), group.second.priority, stamp.nanoseconds());
+    }
+
+    for (std::size_t i = 0; i < velocities.size(); ++i) {
+      (*velocity_hs)[i]->reconfigure(
+        std::chrono::duration<double>(velocities[i].timeout), velocities[i].priority, stamp);
+    }
+    for (std::size_t i = 0; i < locks.size(); ++i) {
+      (*lock_hs)[i]->reconfigure(
+        std::chrono::duration<double>(locks[i].timeout), locks[i].priority, stamp);
+    }
+
+    for (const auto & velocity_h : retired_velocity_hs_) {
+      velocity_h->remove(stamp);
+    }
+    for (const auto & lock_h : retired_lock_hs_) {
+      lock_h->remove(stamp);
+    }
+
+    velocity_hs_.swap(velocity_hs);
+    lock_hs_.swap(lock_hs);
+    velocity_by_id_.swap(velocity_by_id);
+    statistics_msg_.velocities.swap(velocity_statistics);
+    statistics_msg_.locks.swap(lock_statistics);
+
+    // The index of the winner might have changed with the sources, and the
+    // new locks might mask it:
+    updateLock();
+    active_source_lock_priority_ = -1;
+    updateActiveSource();
+    mirror_winner_ = ArbitrationEngine::NO_HANDLE;
+    mirror_status_.winner = StatusMirror::NO_ID;
+    updateMirror();
+  }
+  flushOutput();
+
+  // The callbacks already taken by the removed handles run after their
+  // removal, which the arbitration ignores:
+  for (const auto & velocity_h : retired_velocity_hs_) {
+    velocity_h->unsubscribe();
+  }
+  for (const auto & lock_h : retired_lock_hs_) {
+    lock_h->unsubscribe();
+  }
+
+  // The statistics of the diagnostics are by position:
+  status_->velocity_hs = velocity_hs_;
+  status_->lock_hs = lock_hs_;
+  status_->velocity_statistics.clear();
+  status_->lock_statistics.clear();
+
+  if (sources_pub_) {
+    publishSources();
+  }
+
+  // The new handles have not matched their publishers yet:
+  const auto kept = std::count(kept_velocities.begin(), kept_velocities.end(), true) +
+    std::count(kept_locks.begin(), kept_locks.end(), true);
+  if (ready_ && static_cast<std::size_t>(kept) < velocity_hs_->size() + lock_hs_->size()) {
+    ready_ = false;
+    start_time_ = std::chrono::steady_clock::now();
+
+    std_msgs::msg::Bool ready;
+    ready.data = false;
+    ready_pub_->publish(ready);
+    ready_timer_->reset();
+  }
+
+  RCLCPP_INFO(
+    get_logger(), "Reconfigured with %zu velocity and %zu lock topics (%zu and %zu new)",
+    velocity_hs_->size(), lock_hs_->size(),
+    velocity_hs_->size() - static_cast<std::size_t>(
+      std::count(kept_velocities.begin(), kept_velocities.end(), true)),
+    lock_hs_->size() - static_cast<std::size_t>(
+      std::count(kept_locks.begin(), kept_locks.end(), true)));
 }
 
-template <typename VelocityTopicHandleT>
-bool TwistMux::hasPriority(const VelocityTopicHandleT & twist)
+int TwistMux::getLockPriority()
 {
-  const auto lock_priority = getLockPriority();
+  const auto priority = arbitration_.getLockPriority();
 
-  LockTopicHandle::priority_type priority = 0;
-  std::string velocity_name = "NULL";
+  RCLCPP_DEBUG(get_logger(), "Priority = %d.", static_cast<int>(priority));
 
-  /// max_element on the priority of velocity topic handles satisfying
-  /// that is NOT masked by the lock priority:
-  for (const auto & velocity_h : *velocity_hs_) {
-    std::visit([&](const auto& handle) {
-      if (!handle.isMasked(lock_priority)) {
-        const auto velocity_priority = handle.getPriority();
-        if (priority < velocity_priority) {
-          priority = velocity_priority;
-          velocity_name = handle.getName();
-        }
-      }
-    }, velocity_h);
+  return priority;
+}
+
+bool TwistMux::hasPriority(const VelocityTopicHandle & twist)
+{
+  const auto stamp = twist.getStamp().nanoseconds();
+  if (arbitration_.velocityReceived(twist.getId(), stamp)) {
+    active_ = twist.getId();
+    updateLock();
+    updateActiveSource();
+    return true;
   }
 
-  return twist.getName() == velocity_name;
+  // The active source might have expired just before this message, or a
+  // lock without messages:
+  handover(stamp);
+  updateLock();
+  updateActiveSource();
+  return false;
 }
 
 }  // namespace twist_mux
+
+RCLCPP_COMPONENTS_REGISTER_NODE(twist_mux::TwistMux)
@@ -32,31 +32,89 @@
  * @author Brighten Lee
  */
 
+#include <twist_mux/twist_mux.hpp>
 #include <twist_mux/twist_mux_diagnostics.hpp>
 #include <twist_mux/twist_mux_diagnostics_status.hpp>
 
 #include <diagnostic_updater/diagnostic_updater.hpp>
 
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace
+{
+/// Values of the mux after the values of the handles:
+const char * const MUX_KEYS[] = {
+  "current priority",
+  "loop time in [sec]",
+  "data age in [sec]",
+  "callback time p50 in [sec]",
+  "callback time p99 in [sec]",
+  "callbacks",
+  "winner switches",
+  "handover latency in [sec]",
+  "max handover latency in [sec]",
+};
+constexpr std::size_t MUX_VALUES = sizeof(MUX_KEYS) / sizeof(MUX_KEYS[0]);
+
+/**
+ * @brief format Formats a value into 'value', reusing its storage
+ */
+__attribute__((format(printf, 2, 3)))
+void format(std::string & value, const char * format, ...)
+{
+  char buffer[512];
+  va_list args;
+  va_start(args, format);
+  std::vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  value.assign(buffer);
+}
+}  // namespace
 
 namespace twist_mux
 {
-TwistMuxDiagnostics::TwistMuxDiagnostics(TwistMux * mux)
+TwistMuxDiagnostics::TwistMuxDiagnostics(
+  TwistMux * mux, std::shared_ptr<diagnostic_updater::Updater> updater)
+: diagnostic_(std::move(updater)),
+  name_("Twist mux status")
 {
-  diagnostic_ = std::make_shared<diagnostic_updater::Updater>(mux);
+  // A shared updater reports the tasks of every mux, told apart by node:
+  if (diagnostic_) {
+    name_ += std::string(" ") + mux->get_fully_qualified_name();
+  } else {
+    diagnostic_ = std::make_shared<diagnostic_updater::Updater>(mux);
+  }
   status_ = std::make_shared<status_type>();
 
-  diagnostic_->add("Twist mux status", this, &TwistMuxDiagnostics::diagnostics);
+  updateKeys(*status_);
+  updateValues();
+
+  diagnostic_->add(name_, this, &TwistMuxDiagnostics::diagnostics);
   diagnostic_->setHardwareID("none");
 }
 
-void TwistMuxDiagnostics::update()
+TwistMuxDiagnostics::~TwistMuxDiagnostics()
 {
-  diagnostic_->force_update();
+  // A shared updater outlives the mux:
+  diagnostic_->removeByName(name_);
 }
 
 void TwistMuxDiagnostics::updateStatus(const status_type::ConstPtr & status)
 {
+  std::lock_guard<std::mutex> lock(status_mutex_);
+
+  // The handles only change with the containers, so the keys are built once
+  // instead of on each update:
+  if (status_->velocity_hs != status->velocity_hs || status_->lock_hs != status->lock_hs) {
+    updateKeys(*status);
+  }
+
   status_->velocity_hs = status->velocity_hs;
   status_->lock_hs = status->lock_hs;
   status_->priority = status->priority;
@@ -64,11 +122,26 @@ void TwistMuxDiagnostics::updateStatus(const status_type::ConstPtr & status)
   status_->main_loop_time = status->main_loop_time;
   status_->reading_age = status->reading_age;
 
-  update();
+  status_->callback_latency = status->callback_latency;
+  status_->winner_switches = status->winner_switches;
+  status_->velocity_statistics = status->velocity_statistics;
+  status_->lock_statistics = status->lock_statistics;
+
+  status_->handover_latency = status->handover_latency;
+  status_->max_handover_latency = status->max_handover_latency;
+
+  // Only copied when the state of the handles has changed:
+  if (status_->arbitration.getStateVersion() != status->arbitration.getStateVersion()) {
+    status_->arbitration = status->arbitration;
+  }
+
+  updateValues();
 }
 
 void TwistMuxDiagnostics::diagnostics(diagnostic_updater::DiagnosticStatusWrapper & stat)
 {
+  std::lock_guard<std::mutex> lock(status_mutex_);
+
   /// Check if the loop period is quick enough
   if (status_->main_loop_time > MAIN_LOOP_TIME_MIN) {
     stat.summary(ERROR, "loop time too long");
@@ -78,28 +151,87 @@ void TwistMuxDiagnostics::diagnostics(diagnostic_updater::DiagnosticStatusWrappe
     stat.summary(OK, "ok");
   }
 
-  for (auto & velocity_h : *status_->velocity_hs) {
-    std::visit([&stat, this](auto&& velocity_h) {
-      stat.addf(
-        "velocity " + velocity_h.getName(), " %s (listening to %s @ %fs with priority #%d)",
-        (velocity_h.isMasked(status_->priority) ? "masked" : "unmasked"),
-        velocity_h.getTopic().c_str(),
-        velocity_h.getTimeout().seconds(), static_cast<int>(velocity_h.getPriority()));
-    }, velocity_h );
+  stat.values = values_;
+}
+
+void TwistMuxDiagnostics::updateValues()
+{
+  const auto velocities = status_->velocity_hs->size();
+
+  std::size_t i = 0;
+  auto velocity_statistics = status_->velocity_statistics.cbegin();
+  for (const auto & velocity_h : *status_->velocity_hs) {
+    // The statistics are only there once the mux has collected them:
+    const auto statistics = (velocity_statistics != status_->velocity_statistics.cend()) ?
+      *velocity_statistics++ : status_type::SourceStatistics();
+
+    const HandleState state{
+      status_->arbitration.isMasked(velocity_h->getId()),
+      static_cast<int>(velocity_h->getPriority()),
+      velocity_h->getTimeout().seconds(), std::llround(statistics.rate * 10.0),
+      std::llround(statistics.age * 1e6)};
+    if (!(state == states_[i])) {
+      states_[i] = state;
+      format(
+        values_[i].value, " %s (listening to %s @ %fs with priority #%d, %.1f Hz, age %fs)",
+        (state.masked ? "masked" : "unmasked"), velocity_h->getTopic().c_str(),
+        state.timeout, state.priority, statistics.rate, statistics.age);
+    }
+    ++i;
   }
 
+  auto lock_statistics = status_->lock_statistics.cbegin();
   for (const auto & lock_h : *status_->lock_hs) {
-    stat.addf(
-      "lock " + lock_h.getName(), " %s (listening to %s @ %fs with priority #%d)",
-      (lock_h.isLocked() ? "locked" : "free"), lock_h.getTopic().c_str(),
-      lock_h.getTimeout().seconds(),
-      static_cast<int>(lock_h.getPriority()));
+    const auto statistics = (lock_statistics != status_->lock_statistics.cend()) ?
+      *lock_statistics++ : status_type::SourceStatistics();
+
+    const HandleState state{
+      status_->arbitration.isLocked(lock_h->getId()),
+      static_cast<int>(lock_h->getPriority()),
+      lock_h->getTimeout().seconds(), std::llround(statistics.rate * 10.0), 0};
+    if (!(state == states_[i])) {
+      states_[i] = state;
+      format(
+        values_[i].value, " %s (listening to %s @ %fs with priority #%d, %.1f Hz)",
+        (state.masked ? "locked" : "free"), lock_h->getTopic().c_str(),
+        state.timeout, state.priority, statistics.rate);
+    }
+    ++i;
   }
 
-  stat.add("current priority", static_cast<int>(status_->priority));
+  /// The values of the mux change on every update:
+  auto * value = &values_[velocities + status_->lock_hs->size()];
+  format((value++)->value, "%d", static_cast<int>(status_->priority));
+  format((value++)->value, "%g", status_->main_loop_time);
+  format((value++)->value, "%g", status_->reading_age);
+  format((value++)->value, "%g", 1e-9 * status_->callback_latency.percentile(0.5));
+  format((value++)->value, "%g", 1e-9 * status_->callback_latency.percentile(0.99));
+  format(
+    (value++)->value, "%llu",
+    static_cast<unsigned long long>(status_->callback_latency.total));
+  format((value++)->value, "%llu", static_cast<unsigned long long>(status_->winner_switches));
+  format((value++)->value, "%g", status_->handover_latency);
+  format((value++)->value, "%g", status_->max_handover_latency);
+}
+
+void TwistMuxDiagnostics::updateKeys(const status_type & status)
+{
+  const auto handles = status.velocity_hs->size() + status.lock_hs->size();
+  values_.resize(handles + MUX_VALUES);
+
+  std::size_t i = 0;
+  for (const auto & velocity_h : *status.velocity_hs) {
+    values_[i++].key = "velocity " + velocity_h->getName();
+  }
+  for (const auto & lock_h : *status.lock_hs) {
+    values_[i++].key = "lock " + lock_h->getName();
+  }
+  for (std::size_t j = 0; j < MUX_VALUES; ++j) {
+    values_[i++].key = MUX_KEYS[j];
+  }
 
-  stat.add("loop time in [sec]", status_->main_loop_time);
-  stat.add("data age in [sec]", status_->reading_age);
+  // An impossible state, so all the handles are formatted on the next update:
+  states_.assign(handles, HandleState{false, -1, 0.0, 0, 0});
 }
 
 }  // namespace twist_mux
@@ -0,0 +1,124 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/*
+ * Hosts one twist_mux per robot namespace in a single process, so they
+ * share the DDS participant, the executor and its threads, a single
+ * diagnostics updater and the timers that check their deadlines and update
+ * their diagnostics.
+ */
+
+#include <twist_mux/twist_mux.hpp>
+#include <twist_mux/params_helpers.hpp>
+
+#include <diagnostic_updater/diagnostic_updater.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+
+  auto manager_node = std::make_shared<rclcpp::Node>(
+    "twist_mux_multi", rclcpp::NodeOptions().automatically_declare_parameters_from_overrides(true));
+
+  std::vector<std::string> robots;
+  bool parameter_services = false;
+  bool rosout = false;
+  int threads = 1;
+  twist_mux::fetch_param_or(manager_node, "robots", robots, {});
+  twist_mux::fetch_param_or(manager_node, "parameter_services", parameter_services, false);
+  twist_mux::fetch_param_or(manager_node, "rosout", rosout, false);
+  twist_mux::fetch_param_or(manager_node, "threads", threads, 1);
+
+  if (robots.empty()) {
+    RCLCPP_FATAL(manager_node->get_logger(), "No robot namespaces in the 'robots' parameter.");
+    rclcpp::shutdown();
+    return EXIT_FAILURE;
+  }
+
+  /// The status of every mux is reported by the updater of the manager:
+  auto diagnostics = std::make_shared<diagnostic_updater::Updater>(manager_node);
+  diagnostics->setHardwareID("none");
+
+  /// Each mux is a node in the namespace of its robot, without the services
+  /// and publishers every node has by default unless they are asked for:
+  std::vector<std::shared_ptr<twist_mux::TwistMux>> muxes;
+  muxes.reserve(robots.size());
+  for (const auto & robot : robots) {
+    auto options = rclcpp::NodeOptions()
+      .arguments({"--ros-args", "-r", "__ns:=/" + robot})
+      .start_parameter_services(parameter_services)
+      .start_parameter_event_publisher(parameter_services)
+      .enable_rosout(rosout);
+    muxes.push_back(std::make_shared<twist_mux::TwistMux>(options, diagnostics));
+  }
+
+  /// One timer each for the deadlines and the diagnostics of all the muxes,
+  /// instead of two per mux; a deadline check is a single compare when
+  /// nothing is due:
+  auto expiry_timer = manager_node->create_wall_timer(
+    twist_mux::TwistMux::EXPIRY_CHECK_PERIOD, [&muxes]() -> void {
+      for (const auto & mux : muxes) {
+        mux->checkExpiry();
+      }
+    });
+  auto diagnostics_timer = manager_node->create_wall_timer(
+    twist_mux::TwistMux::DIAGNOSTICS_PERIOD, [&muxes]() -> void {
+      for (const auto & mux : muxes) {
+        mux->updateDiagnostics();
+      }
+    });
+
+  RCLCPP_INFO(
+    manager_node->get_logger(), "Hosting %zu twist_mux instances on %d thread(s).",
+    muxes.size(), threads);
+
+  auto spin = [&](rclcpp::Executor & executor) {
+      executor.add_node(manager_node);
+      for (const auto & mux : muxes) {
+        executor.add_node(mux);
+      }
+      executor.spin();
+    };
+
+  if (threads > 1) {
+    rclcpp::executors::MultiThreadedExecutor executor(
+      rclcpp::ExecutorOptions(), static_cast<std::size_t>(threads));
+    spin(executor);
+  } else {
+    rclcpp::executors::SingleThreadedExecutor executor;
+    spin(executor);
+  }
+
+  rclcpp::shutdown();
+
+  return EXIT_SUCCESS;
+}
@@ -33,8 +33,88 @@
  */
 
 #include <twist_mux/twist_mux.hpp>
+#include <twist_mux/params_helpers.hpp>
 
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+/// Stack pre-faulted when locking the memory, so the first deep calls of
+/// the command path do not page fault:
+constexpr std::size_t STACK_PREFAULT_SIZE = 512 * 1024;
+
+/**
+ * @brief The RealtimeConfig struct holds the real-time settings of the
+ * command path
+ */
+struct RealtimeConfig
+{
+  /// SCHED_FIFO priority, 0 to keep the default scheduling:
+  int priority = 0;
+  /// CPUs the command threads are pinned to, empty to not pin them:
+  std::vector<int64_t> cpus;
+  /// Lock all the memory of the process once initialized:
+  bool lock_memory = false;
+};
+
+__attribute__((noinline)) void prefaultStack()
+{
+  unsigned char stack[STACK_PREFAULT_SIZE];
+  volatile unsigned char * pages = stack;
+  for (std::size_t i = 0; i < STACK_PREFAULT_SIZE; i += 4096) {
+    pages[i] = 0;
+  }
+}
+
+/**
+ * @brief configureThread Applies the scheduling and affinity of 'config' to
+ * the calling thread; the threads it creates afterwards inherit them
+ */
+void configureThread(const RealtimeConfig & config, const rclcpp::Logger & logger)
+{
+  if (!config.cpus.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const auto cpu : config.cpus) {
+      CPU_SET(static_cast<int>(cpu), &cpu_set);
+    }
+    const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if (error != 0) {
+      RCLCPP_ERROR(logger, "Could not set the CPU affinity: %s", std::strerror(error));
+    }
+  }
+
+  if (config.priority > 0) {
+    sched_param param;
+    param.sched_priority = config.priority;
+    const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error != 0) {
+      RCLCPP_ERROR(
+        logger, "Could not set SCHED_FIFO with priority %d: %s", config.priority,
+        std::strerror(error));
+    }
+  }
+}
+
+void lockMemory(const rclcpp::Logger & logger)
+{
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    RCLCPP_ERROR(logger, "Could not lock the memory: %s", std::strerror(errno));
+    return;
+  }
+  prefaultStack();
+}
+}  // namespace
 
 int main(int argc, char * argv[])
 {
@@ -42,9 +122,65 @@ int main(int argc, char * argv[])
 
   auto twist_mux_node = std::make_shared<twist_mux::TwistMux>();
 
-  twist_mux_node->init();
+  RealtimeConfig realtime;
+  twist_mux::fetch_param_or(twist_mux_node, "realtime.priority", realtime.priority, 0);
+  twist_mux::fetch_param_or(twist_mux_node, "realtime.cpus", realtime.cpus, {});
+  twist_mux::fetch_param_or(twist_mux_node, "realtime.lock_memory", realtime.lock_memory, false);
+
+  // The node is fully initialized, so nothing big is allocated after this:
+  if (realtime.lock_memory) {
+    lockMemory(twist_mux_node->get_logger());
+  }
+
+  auto command_group = twist_mux_node->getCommandCallbackGroup();
+  if (command_group) {
+    /// The command callbacks get their own threads, and the rest of the node
+    /// (diagnostics, parameter services) a separate one, so they never
+    /// delay the velocity commands:
+    rclcpp::executors::MultiThreadedExecutor command_executor(
+      rclcpp::ExecutorOptions(), twist_mux_node->getCommandThreads());
+    command_executor.add_callback_group(command_group, twist_mux_node->get_node_base_interface());
+
+    /// The groups with their own thread take and deserialize their messages
+    /// in parallel with the other sources:
+    std::vector<std::unique_ptr<rclcpp::executors::SingleThreadedExecutor>> group_executors;
+    for (const auto & group : twist_mux_node->getGroupCallbackGroups()) {
+      if (group) {
+        group_executors.push_back(std::make_unique<rclcpp::executors::SingleThreadedExecutor>());
+        group_executors.back()->add_callback_group(
+          group, twist_mux_node->get_node_base_interface());
+      }
+    }
+
+    rclcpp::executors::SingleThreadedExecutor diagnostics_executor;
+    diagnostics_executor.add_node(twist_mux_node);
+
+    std::thread diagnostics_thread([&diagnostics_executor]() {diagnostics_executor.spin();});
+
+    std::vector<std::thread> group_threads;
+    for (auto & executor : group_executors) {
+      group_threads.emplace_back(
+        [&executor, &realtime, &twist_mux_node]() {
+          configureThread(realtime, twist_mux_node->get_logger());
+          executor->spin();
+        });
+    }
+
+    // Only the command threads, created by spin(), inherit the real-time
+    // settings of this thread:
+    configureThread(realtime, twist_mux_node->get_logger());
+    command_executor.spin();
 
-  rclcpp::spin(twist_mux_node);
+    for (std::size_t i = 0; i < group_executors.size(); ++i) {
+      group_executors[i]->cancel();
+      group_threads[i].join();
+    }
+    diagnostics_executor.cancel();
+    diagnostics_thread.join();
+  } else {
+    configureThread(realtime, twist_mux_node->get_logger());
+    rclcpp::spin(twist_mux_node);
+  }
 
   rclcpp::shutdown();
 
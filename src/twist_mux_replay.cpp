@@ -0,0 +1,100 @@
+// Copyright 2020 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <twist_mux/arbitration_engine.hpp>
+#include <twist_mux/event_recorder.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+
+/**
+ * Replays a trace recorded by twist_mux (recording.enabled) through the
+ * arbitration engine, as fast as possible, checks that its decisions are the
+ * recorded ones, and reports the time per operation:
+ *
+ *   twist_mux_replay <trace> [repetitions]
+ */
+int main(int argc, char * argv[])
+{
+  if (argc < 2 || argc > 3) {
+    std::fprintf(stderr, "Usage: %s <trace> [repetitions]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int repetitions = (argc == 3) ? std::max(std::atoi(argv[2]), 1) : 1;
+
+  std::vector<twist_mux::EventRecorder::Record> records;
+  std::uint64_t setup_dropped = 0;
+  try {
+    records = twist_mux::EventRecorder::read(argv[1], &setup_dropped);
+  } catch (const std::exception & e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  if (setup_dropped > 0) {
+    std::fprintf(
+      stderr, "Warning: %llu setup records were dropped, the replay is not faithful\n",
+      static_cast<unsigned long long>(setup_dropped));
+  }
+
+  twist_mux::ReplayResult result;
+  std::chrono::steady_clock::duration elapsed(0);
+  for (int i = 0; i < repetitions; ++i) {
+    twist_mux::ArbitrationEngine engine;
+    const auto start = std::chrono::steady_clock::now();
+    result = twist_mux::replay(records, engine);
+    elapsed += std::chrono::steady_clock::now() - start;
+  }
+
+  const double replayed = std::chrono::duration<double>(elapsed).count() / repetitions;
+  const double span = 1e-9 * static_cast<double>(result.span);
+
+  std::printf("records:    %zu\n", result.records);
+  std::printf("operations: %zu\n", result.operations);
+  std::printf("mismatches: %zu", result.mismatches);
+  if (result.mismatches > 0) {
+    std::printf(
+      " (first at sequence %llu)", static_cast<unsigned long long>(result.first_mismatch));
+  }
+  std::printf("\n");
+  if (result.operations > 0) {
+    std::printf("per op:     %.1f ns\n", 1e9 * replayed / static_cast<double>(result.operations));
+  }
+  if (replayed > 0.0 && span > 0.0) {
+    std::printf("speed-up:   %.0fx over %.3f s recorded\n", span / replayed, span);
+  }
+
+  return (result.mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
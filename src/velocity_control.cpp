@@ -0,0 +1,123 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <twist_mux/velocity_control.hpp>
+
+#include <cmath>
+#include <stdexcept>
+
+namespace twist_mux
+{
+Velocity::Velocity(double min_velocity, double max_velocity, int num_steps)
+: min_(min_velocity), step_incr_(0.0)
+{
+  if (min_velocity <= 0.0 || max_velocity <= 0.0 || num_steps <= 0) {
+    throw std::invalid_argument("velocity and number of steps must be positive");
+  }
+
+  if (num_steps > 1) {
+    step_incr_ = (max_velocity - min_velocity) / (num_steps - 1);
+  }
+}
+
+VelocityControl::VelocityControl(
+  int num_steps, int init_step, const Velocity & forward, const Velocity & backward,
+  const Velocity & lateral, const Velocity & angular)
+: num_steps_(num_steps), init_step_(init_step), forward_(forward), backward_(backward),
+  lateral_(lateral), angular_(angular), step_(init_step), angular_step_(init_step)
+{
+  if (init_step < 1 || init_step > num_steps) {
+    throw std::invalid_argument("initial step outside the range of steps");
+  }
+}
+
+bool VelocityControl::isValid(const geometry_msgs::msg::Twist & cmd)
+{
+  using std::abs;
+
+  return cmd.linear.z == 0.0 && cmd.angular.x == 0.0 && cmd.angular.y == 0.0 &&
+         abs(cmd.linear.x) <= 1.0 && abs(cmd.linear.y) <= 1.0 && abs(cmd.angular.z) <= 1.0;
+}
+
+bool VelocityControl::scaleTwist(
+  const geometry_msgs::msg::Twist & cmd, geometry_msgs::msg::Twist & twist) const
+{
+  twist = geometry_msgs::msg::Twist();
+
+  if (!isValid(cmd)) {
+    return false;
+  }
+
+  if (cmd.linear.x >= 0.0) {
+    twist.linear.x = forward_(cmd.linear.x, step_);
+  } else {
+    twist.linear.x = backward_(cmd.linear.x, step_);
+  }
+  twist.linear.y = lateral_(cmd.linear.y, step_);
+  twist.angular.z = angular_(cmd.angular.z, angular_step_);
+
+  return true;
+}
+
+void VelocityControl::increaseTurbo()
+{
+  if (step_ < num_steps_) {
+    ++step_;
+  }
+  increaseAngularTurbo();
+}
+
+void VelocityControl::decreaseTurbo()
+{
+  if (step_ > 1) {
+    --step_;
+  }
+  decreaseAngularTurbo();
+}
+
+void VelocityControl::increaseAngularTurbo()
+{
+  if (angular_step_ < num_steps_) {
+    ++angular_step_;
+  }
+}
+
+void VelocityControl::decreaseAngularTurbo()
+{
+  if (angular_step_ > 1) {
+    --angular_step_;
+  }
+}
+
+void VelocityControl::resetTurbo()
+{
+  step_ = init_step_;
+  angular_step_ = init_step_;
+}
+
+}  // namespace twist_mux
@@ -0,0 +1,123 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <twist_mux/velocity_limiter.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+typedef twist_mux::VelocityLimiter::axes_type axes_type;
+
+axes_type toAxes(const geometry_msgs::msg::Twist & twist)
+{
+  return {twist.linear.x, twist.linear.y, twist.linear.z,
+    twist.angular.x, twist.angular.y, twist.angular.z};
+}
+
+void fromAxes(const axes_type & axes, geometry_msgs::msg::Twist & twist)
+{
+  twist.linear.x = axes[0];
+  twist.linear.y = axes[1];
+  twist.linear.z = axes[2];
+  twist.angular.x = axes[3];
+  twist.angular.y = axes[4];
+  twist.angular.z = axes[5];
+}
+}  // namespace
+
+namespace twist_mux
+{
+constexpr std::size_t VelocityLimiter::AXES;
+
+VelocityLimiter::VelocityLimiter(const axes_type & max_acceleration, const axes_type & max_jerk)
+: max_acceleration_(max_acceleration),
+  max_jerk_(max_jerk),
+  acceleration_{}
+{
+}
+
+bool VelocityLimiter::limit(
+  geometry_msgs::msg::Twist & twist, const geometry_msgs::msg::Twist & last,
+  double dt, bool brake)
+{
+  if (dt <= 0.0) {
+    return false;
+  }
+
+  auto velocity = toAxes(twist);
+  const auto last_velocity = toAxes(last);
+
+  bool limited = false;
+  for (std::size_t i = 0; i < AXES; ++i) {
+    const double target = (velocity[i] - last_velocity[i]) / dt;
+
+    // Slowing down towards zero:
+    if (brake && velocity[i] * last_velocity[i] >= 0.0 &&
+      std::abs(velocity[i]) <= std::abs(last_velocity[i]))
+    {
+      acceleration_[i] = 0.0;
+      continue;
+    }
+
+    double acceleration = target;
+
+    if (max_jerk_[i] > 0.0) {
+      const double max_change = max_jerk_[i] * dt;
+      acceleration = std::clamp(
+        acceleration, acceleration_[i] - max_change, acceleration_[i] + max_change);
+    }
+    if (max_acceleration_[i] > 0.0) {
+      acceleration = std::clamp(acceleration, -max_acceleration_[i], max_acceleration_[i]);
+    }
+
+    // The jerk limit must not make the velocity overshoot the command:
+    if ((target >= 0.0 && acceleration > target) || (target <= 0.0 && acceleration < target)) {
+      acceleration = target;
+    }
+
+    if (acceleration != target) {
+      velocity[i] = last_velocity[i] + acceleration * dt;
+      limited = true;
+    }
+    acceleration_[i] = acceleration;
+  }
+
+  if (limited) {
+    fromAxes(velocity, twist);
+  }
+  return limited;
+}
+
+void VelocityLimiter::reset()
+{
+  acceleration_.fill(0.0);
+}
+
+}  // namespace twist_mux
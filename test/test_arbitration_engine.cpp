@@ -0,0 +1,402 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+
+#include <twist_mux/arbitration_engine.hpp>
+#include <twist_mux/deadline_scheduler.hpp>
+#include <twist_mux/lock_priority_index.hpp>
+
+#include <vector>
+
+using twist_mux::ArbitrationEngine;
+using twist_mux::DeadlineScheduler;
+using twist_mux::LockPriorityIndex;
+
+namespace
+{
+constexpr ArbitrationEngine::time_type ms = 1000000;
+}  // namespace
+
+TEST(ArbitrationEngine, EmptyHasNoWinner)
+{
+  ArbitrationEngine engine;
+  EXPECT_EQ(ArbitrationEngine::NO_HANDLE, engine.getWinner());
+  EXPECT_EQ(0, engine.getLockPriority());
+}
+
+TEST(ArbitrationEngine, HighestPriorityWins)
+{
+  ArbitrationEngine engine;
+  const auto low = engine.addVelocity(10, 500 * ms);
+  const auto high = engine.addVelocity(100, 500 * ms);
+
+  EXPECT_TRUE(engine.velocityReceived(low, 1000 * ms));
+  EXPECT_TRUE(engine.velocityReceived(high, 1010 * ms));
+  EXPECT_FALSE(engine.velocityReceived(low, 1020 * ms));
+  EXPECT_TRUE(engine.velocityReceived(high, 1030 * ms));
+  engine.update(1040 * ms);
+  EXPECT_EQ(high, engine.getWinner());
+}
+
+TEST(ArbitrationEngine, FallsBackWhenWinnerExpires)
+{
+  ArbitrationEngine engine;
+  const auto low = engine.addVelocity(10, 500 * ms);
+  const auto high = engine.addVelocity(100, 300 * ms);
+
+  EXPECT_TRUE(engine.velocityReceived(high, 1000 * ms));
+  EXPECT_FALSE(engine.velocityReceived(low, 1200 * ms));
+  EXPECT_FALSE(engine.velocityReceived(low, 1300 * ms));
+  EXPECT_TRUE(engine.velocityReceived(low, 1301 * ms));
+  engine.update(1400 * ms);
+  EXPECT_EQ(low, engine.getWinner());
+  engine.update(1802 * ms);
+  EXPECT_TRUE(engine.hasExpired(low));
+  EXPECT_EQ(ArbitrationEngine::NO_HANDLE, engine.getWinner());
+}
+
+TEST(ArbitrationEngine, EqualPrioritiesKeepRegistrationOrder)
+{
+  ArbitrationEngine engine;
+  const auto first = engine.addVelocity(100, 500 * ms);
+  const auto second = engine.addVelocity(100, 500 * ms);
+
+  EXPECT_TRUE(engine.velocityReceived(second, 1000 * ms));
+  EXPECT_TRUE(engine.velocityReceived(first, 1010 * ms));
+  EXPECT_FALSE(engine.velocityReceived(second, 1020 * ms));
+}
+
+TEST(ArbitrationEngine, ZeroPriorityNeverWins)
+{
+  ArbitrationEngine engine;
+  const auto zero = engine.addVelocity(0, 500 * ms);
+
+  EXPECT_FALSE(engine.velocityReceived(zero, 1000 * ms));
+}
+
+TEST(ArbitrationEngine, LocksMaskLowerPriorities)
+{
+  ArbitrationEngine engine;
+  const auto velocity = engine.addVelocity(50, 0);
+  const auto lock = engine.addLock(100, 0);
+
+  EXPECT_TRUE(engine.velocityReceived(velocity, 1000 * ms));
+
+  engine.lockReceived(lock, true, 1010 * ms);
+  EXPECT_EQ(100, engine.getLockPriority());
+  EXPECT_FALSE(engine.velocityReceived(velocity, 1020 * ms));
+
+  engine.lockReceived(lock, false, 1030 * ms);
+  EXPECT_TRUE(engine.velocityReceived(velocity, 1040 * ms));
+}
+
+TEST(ArbitrationEngine, ExpiredLockIsLocked)
+{
+  ArbitrationEngine engine;
+  const auto velocity = engine.addVelocity(50, 0);
+  const auto lock = engine.addLock(255, 500 * ms);
+
+  // Never received, hence expired:
+  EXPECT_FALSE(engine.velocityReceived(velocity, 1000 * ms));
+
+  engine.lockReceived(lock, false, 1000 * ms);
+  EXPECT_TRUE(engine.velocityReceived(velocity, 1100 * ms));
+  engine.lockReceived(lock, false, 1400 * ms);
+  EXPECT_TRUE(engine.velocityReceived(velocity, 1800 * ms));
+  EXPECT_FALSE(engine.velocityReceived(velocity, 1901 * ms));
+  EXPECT_TRUE(engine.isLocked(lock));
+}
+
+TEST(ArbitrationEngine, UpdateExpiresWithoutMessages)
+{
+  ArbitrationEngine engine;
+  const auto velocity = engine.addVelocity(10, 500 * ms);
+  const auto no_timeout = engine.addVelocity(5, 0);
+
+  EXPECT_TRUE(engine.velocityReceived(velocity, 1000 * ms));
+  EXPECT_EQ(1500 * ms, engine.nextDeadline());
+
+  engine.update(1500 * ms);
+  EXPECT_FALSE(engine.hasExpired(velocity));
+  engine.update(1501 * ms);
+  EXPECT_TRUE(engine.hasExpired(velocity));
+  EXPECT_FALSE(engine.hasExpired(no_timeout));
+  EXPECT_EQ(no_timeout, engine.getWinner());
+  EXPECT_EQ(ArbitrationEngine::NEVER, engine.nextDeadline());
+}
+
+TEST(ArbitrationEngine, CountsWinnerSwitches)
+{
+  ArbitrationEngine engine;
+  const auto low = engine.addVelocity(10, 500 * ms);
+  const auto high = engine.addVelocity(100, 300 * ms);
+
+  EXPECT_TRUE(engine.velocityReceived(low, 1000 * ms));
+  EXPECT_TRUE(engine.velocityReceived(low, 1010 * ms));
+  EXPECT_EQ(1u, engine.getWinnerSwitches());
+
+  EXPECT_TRUE(engine.velocityReceived(high, 1020 * ms));
+  EXPECT_FALSE(engine.velocityReceived(low, 1030 * ms));
+  EXPECT_EQ(2u, engine.getWinnerSwitches());
+
+  // The high priority source expires, and then the low priority one:
+  engine.update(1400 * ms);
+  EXPECT_EQ(low, engine.getWinner());
+  engine.update(1600 * ms);
+  EXPECT_EQ(ArbitrationEngine::NO_HANDLE, engine.getWinner());
+  EXPECT_EQ(4u, engine.getWinnerSwitches());
+}
+
+TEST(ArbitrationEngine, AccountsMaskedAndWinnerTime)
+{
+  ArbitrationEngine engine;
+  const auto low = engine.addVelocity(10, 500 * ms);
+  const auto high = engine.addVelocity(100, 300 * ms);
+  const auto lock = engine.addLock(50, 0);
+
+  engine.update(1000 * ms);
+  EXPECT_TRUE(engine.velocityReceived(low, 1000 * ms));
+  EXPECT_TRUE(engine.velocityReceived(high, 1100 * ms));
+
+  // The lock masks the low priority source for 200ms:
+  engine.lockReceived(lock, true, 1200 * ms);
+  engine.lockReceived(lock, false, 1400 * ms);
+
+  // The high priority source expires at 1400ms:
+  EXPECT_TRUE(engine.velocityReceived(low, 1450 * ms));
+
+  EXPECT_EQ(200 * ms, engine.getMaskedTime(low, 1500 * ms));
+  EXPECT_EQ(200 * ms, engine.getMaskedTime(lock, 1500 * ms));
+  EXPECT_EQ(100 * ms + 100 * ms, engine.getMaskedTime(high, 1500 * ms));
+  EXPECT_EQ(300 * ms, engine.getWinnerTime(high, 1500 * ms));
+  EXPECT_EQ(100 * ms + 50 * ms, engine.getWinnerTime(low, 1500 * ms));
+}
+
+TEST(DeadlineScheduler, ExpiresInDeadlineOrder)
+{
+  DeadlineScheduler scheduler;
+  scheduler.schedule(0, 30);
+  scheduler.schedule(1, 10);
+  scheduler.schedule(2, 20);
+  scheduler.schedule(3, 40);
+
+  // Moving a deadline keeps a single entry per id:
+  scheduler.schedule(1, 50);
+  scheduler.cancel(3);
+  EXPECT_EQ(20, scheduler.nextDeadline());
+
+  std::vector<DeadlineScheduler::id_type> expired;
+  scheduler.expire(
+    100, [&expired](DeadlineScheduler::id_type id) {expired.push_back(id);});
+
+  EXPECT_EQ((std::vector<DeadlineScheduler::id_type>{2, 0, 1}), expired);
+  EXPECT_EQ(DeadlineScheduler::NEVER, scheduler.nextDeadline());
+  EXPECT_FALSE(scheduler.isScheduled(3));
+}
+
+TEST(ArbitrationEngine, LowerLockDoesNotUnlockHigherOne)
+{
+  ArbitrationEngine engine;
+  const auto velocity = engine.addVelocity(150, 0);
+  const auto low = engine.addLock(100, 0);
+  const auto high = engine.addLock(200, 0);
+
+  engine.lockReceived(high, true, 1000 * ms);
+  engine.lockReceived(low, true, 1000 * ms);
+  EXPECT_EQ(200, engine.getLockPriority());
+
+  engine.lockReceived(high, false, 1010 * ms);
+  EXPECT_EQ(100, engine.getLockPriority());
+  EXPECT_TRUE(engine.velocityReceived(velocity, 1020 * ms));
+
+  engine.lockReceived(low, false, 1030 * ms);
+  EXPECT_EQ(0, engine.getLockPriority());
+}
+
+TEST(ArbitrationEngine, GroupWinnersCompeteWithGroupPriority)
+{
+  ArbitrationEngine engine;
+  const auto fleet = engine.addGroup(50);
+  const auto teleop = engine.addVelocity(100, 500 * ms);
+  const auto low = engine.addVelocity(10, 500 * ms, fleet);
+  const auto high = engine.addVelocity(200, 300 * ms, fleet);
+  const auto lock = engine.addLock(80, 0);
+
+  EXPECT_EQ(fleet, engine.getGroup(low));
+  EXPECT_EQ(ArbitrationEngine::NO_GROUP, engine.getGroup(teleop));
+  EXPECT_EQ(50, engine.getTopPriority(high));
+
+  // Within the group the highest priority wins:
+  EXPECT_TRUE(engine.velocityReceived(low, 1000 * ms));
+  EXPECT_TRUE(engine.velocityReceived(high, 1010 * ms));
+  EXPECT_FALSE(engine.velocityReceived(low, 1020 * ms));
+
+  // The group competes with its own priority, below the ungrouped handle:
+  EXPECT_TRUE(engine.velocityReceived(teleop, 1030 * ms));
+  EXPECT_FALSE(engine.velocityReceived(high, 1040 * ms));
+
+  // The lock masks the whole group, but not the ungrouped handle:
+  engine.lockReceived(lock, true, 1050 * ms);
+  EXPECT_TRUE(engine.isMasked(high));
+  EXPECT_FALSE(engine.isMasked(teleop));
+  EXPECT_TRUE(engine.velocityReceived(teleop, 1060 * ms));
+  engine.lockReceived(lock, false, 1070 * ms);
+  EXPECT_FALSE(engine.isMasked(high));
+
+  ArbitrationEngine grouped;
+  const auto group = grouped.addGroup(50);
+  const auto member_low = grouped.addVelocity(10, 500 * ms, group);
+  const auto member_high = grouped.addVelocity(200, 300 * ms, group);
+  const auto other = grouped.addVelocity(40, 2000 * ms);
+
+  EXPECT_TRUE(grouped.velocityReceived(other, 1000 * ms));
+  EXPECT_TRUE(grouped.velocityReceived(member_high, 1010 * ms));
+  EXPECT_FALSE(grouped.velocityReceived(other, 1020 * ms));
+  EXPECT_FALSE(grouped.velocityReceived(member_low, 1200 * ms));
+
+  // When the group winner expires, the next member takes over the group:
+  grouped.update(1311 * ms);
+  EXPECT_EQ(member_low, grouped.getWinner());
+  EXPECT_TRUE(grouped.velocityReceived(member_low, 1320 * ms));
+
+  // And the ungrouped handle when the whole group expires:
+  grouped.update(1821 * ms);
+  EXPECT_EQ(other, grouped.getWinner());
+}
+
+TEST(ArbitrationEngine, ReconfiguresHandles)
+{
+  ArbitrationEngine engine;
+  const auto low = engine.addVelocity(10, 500 * ms);
+  const auto high = engine.addVelocity(100, 500 * ms);
+  const auto lock = engine.addLock(50, 0);
+
+  EXPECT_TRUE(engine.velocityReceived(low, 1000 * ms));
+  EXPECT_TRUE(engine.velocityReceived(high, 1010 * ms));
+
+  // A lower priority gives the lead back to the other handle:
+  engine.setPriority(high, 5, 1020 * ms);
+  EXPECT_EQ(low, engine.getWinner());
+
+  // A removed handle never wins again, even with messages in flight:
+  engine.remove(low, 1030 * ms);
+  EXPECT_EQ(high, engine.getWinner());
+  EXPECT_FALSE(engine.velocityReceived(low, 1040 * ms));
+  EXPECT_TRUE(engine.velocityReceived(high, 1050 * ms));
+
+  // Handles added later take part in the arbitration:
+  const auto late = engine.addVelocity(200, 500 * ms);
+  EXPECT_TRUE(engine.velocityReceived(late, 1060 * ms));
+
+  // A removed lock releases its priority:
+  engine.lockReceived(lock, true, 1070 * ms);
+  engine.setPriority(lock, 250, 1080 * ms);
+  EXPECT_EQ(250, engine.getLockPriority());
+  EXPECT_EQ(ArbitrationEngine::NO_HANDLE, engine.getWinner());
+  engine.remove(lock, 1090 * ms);
+  EXPECT_EQ(0, engine.getLockPriority());
+  EXPECT_EQ(late, engine.getWinner());
+}
+
+TEST(ArbitrationEngine, ExpiresOnEvents)
+{
+  ArbitrationEngine engine;
+  const auto low = engine.addVelocity(10, 500 * ms);
+  const auto high = engine.addVelocity(100, 0);
+  const auto lock = engine.addLock(200, 0);
+
+  EXPECT_FALSE(engine.velocityReceived(low, 1000 * ms));
+  EXPECT_TRUE(engine.velocityReceived(high, 1010 * ms));
+
+  // A handle without timeout only expires on an event:
+  engine.expireNow(high, 1020 * ms);
+  EXPECT_TRUE(engine.hasExpired(high));
+  EXPECT_EQ(low, engine.getWinner());
+  EXPECT_EQ(1020 * ms, engine.getDeadline(high));
+
+  EXPECT_TRUE(engine.velocityReceived(high, 1030 * ms));
+  EXPECT_FALSE(engine.hasExpired(high));
+  EXPECT_EQ(ArbitrationEngine::NEVER, engine.getDeadline(high));
+
+  // An expired lock is locked:
+  engine.lockReceived(lock, false, 1040 * ms);
+  engine.expireNow(lock, 1050 * ms);
+  EXPECT_EQ(200, engine.getLockPriority());
+  EXPECT_EQ(ArbitrationEngine::NO_HANDLE, engine.getWinner());
+}
+
+TEST(LockPriorityIndex, HighestActivePriority)
+{
+  LockPriorityIndex index;
+  EXPECT_EQ(0, index.highest());
+
+  index.add(3);
+  index.add(130);
+  index.add(130);
+  index.add(255);
+  EXPECT_EQ(255, index.highest());
+
+  index.remove(255);
+  EXPECT_EQ(130, index.highest());
+  index.remove(130);
+  EXPECT_EQ(130, index.highest());
+  index.remove(130);
+  EXPECT_EQ(3, index.highest());
+  index.remove(3);
+  EXPECT_EQ(0, index.highest());
+}
+
+TEST(ArbitrationEngine, StateVersionOnlyChangesWithTheState)
+{
+  ArbitrationEngine engine;
+  const auto low = engine.addVelocity(10, 500 * ms);
+  const auto high = engine.addVelocity(100, 500 * ms);
+  const auto lock = engine.addLock(50, 0);
+
+  engine.velocityReceived(low, 1000 * ms);
+  engine.lockReceived(lock, false, 1000 * ms);
+
+  // Messages that change neither the masking nor the winner:
+  auto version = engine.getStateVersion();
+  engine.velocityReceived(low, 1010 * ms);
+  engine.lockReceived(lock, false, 1020 * ms);
+  engine.update(1030 * ms);
+  EXPECT_EQ(version, engine.getStateVersion());
+
+  engine.velocityReceived(high, 1040 * ms);
+  EXPECT_LT(version, engine.getStateVersion());
+
+  version = engine.getStateVersion();
+  engine.lockReceived(lock, true, 1050 * ms);
+  EXPECT_LT(version, engine.getStateVersion());
+
+  version = engine.getStateVersion();
+  engine.setPriority(low, 20, 1060 * ms);
+  EXPECT_LT(version, engine.getStateVersion());
+}
@@ -0,0 +1,194 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+
+#include <twist_mux/arbitration_engine.hpp>
+#include <twist_mux/event_recorder.hpp>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using twist_mux::ArbitrationEngine;
+using twist_mux::EventRecorder;
+
+namespace
+{
+constexpr ArbitrationEngine::time_type ms = 1000000;
+
+std::string tracePath()
+{
+  return "/tmp/test_event_recorder_" + std::to_string(::getpid()) + ".rec";
+}
+
+/**
+ * @brief runScenario Drives the engine through groups, locks, expiry and a
+ * reconfiguration
+ */
+void runScenario(ArbitrationEngine & engine)
+{
+  const auto group = engine.addGroup(50);
+  const auto joystick = engine.addVelocity(100, 200 * ms);
+  const auto navigation = engine.addVelocity(10, 500 * ms);
+  const auto teleop = engine.addVelocity(20, 300 * ms, group);
+  const auto tablet = engine.addVelocity(30, 300 * ms, group);
+  const auto pause = engine.addLock(60, 0);
+
+  ArbitrationEngine::time_type now = 1000 * ms;
+  for (int i = 0; i < 20; ++i, now += 50 * ms) {
+    engine.velocityReceived(navigation, now);
+    if (i % 3 == 0) {
+      engine.velocityReceived(teleop, now + ms);
+    }
+    if (i > 10) {
+      engine.velocityReceived(tablet, now + 2 * ms);
+    }
+    if (i == 5) {
+      engine.velocityReceived(joystick, now + 3 * ms);
+    }
+    if (i == 8) {
+      engine.lockReceived(pause, true, now + 4 * ms);
+    }
+    if (i == 12) {
+      engine.lockReceived(pause, false, now + 4 * ms);
+      engine.setPriority(navigation, 80, now + 5 * ms);
+    }
+    if (i == 15) {
+      engine.expireNow(navigation, now + 6 * ms);
+      engine.setGroupPriority(group, 90, now + 6 * ms);
+      engine.remove(teleop, now + 6 * ms);
+    }
+    engine.update(now + 10 * ms);
+    engine.getWinner();
+  }
+}
+}  // namespace
+
+TEST(EventRecorder, ReplaysTheRecordedDecisions)
+{
+  const auto path = tracePath();
+  {
+    EventRecorder recorder(path, 1024);
+    ArbitrationEngine engine;
+    engine.setRecorder(&recorder);
+    runScenario(engine);
+  }
+
+  std::uint64_t setup_dropped = 1;
+  const auto records = EventRecorder::read(path, &setup_dropped);
+  EXPECT_EQ(0u, setup_dropped);
+  ASSERT_FALSE(records.empty());
+  EXPECT_EQ(EventRecorder::ADD_GROUP, records.front().type);
+  for (std::size_t i = 1; i < records.size(); ++i) {
+    EXPECT_LT(records[i - 1].sequence, records[i].sequence);
+  }
+
+  ArbitrationEngine engine;
+  const auto result = twist_mux::replay(records, engine);
+  EXPECT_EQ(records.size(), result.records);
+  EXPECT_GT(result.operations, 0u);
+  EXPECT_EQ(0u, result.mismatches);
+
+  // The replay ends in the recorded state:
+  ArbitrationEngine expected;
+  runScenario(expected);
+  EXPECT_EQ(expected.getWinner(), engine.getWinner());
+  EXPECT_EQ(expected.getWinnerSwitches(), engine.getWinnerSwitches());
+
+  std::remove(path.c_str());
+}
+
+TEST(EventRecorder, KeepsTheSetupAndTheLastEvents)
+{
+  const auto path = tracePath();
+  {
+    EventRecorder recorder(path, 8, 2);
+    recorder.record(EventRecorder::ADD_VELOCITY, 0, 0, EventRecorder::NO_ID, 10, 0, 100 * ms);
+    recorder.record(EventRecorder::ADD_LOCK, 0, 1, EventRecorder::NO_ID, 20, 0, 0);
+    // Does not fit in the setup region:
+    EXPECT_EQ(nullptr, recorder.record(EventRecorder::REMOVE, 0, 1));
+    for (int i = 0; i < 20; ++i) {
+      recorder.record(EventRecorder::VELOCITY, i * ms, 0);
+    }
+  }
+
+  std::uint64_t setup_dropped = 0;
+  const auto records = EventRecorder::read(path, &setup_dropped);
+  EXPECT_EQ(1u, setup_dropped);
+  ASSERT_EQ(10u, records.size());
+  EXPECT_EQ(EventRecorder::ADD_VELOCITY, records[0].type);
+  EXPECT_EQ(EventRecorder::ADD_LOCK, records[1].type);
+  for (std::size_t i = 2; i < records.size(); ++i) {
+    EXPECT_EQ(EventRecorder::VELOCITY, records[i].type);
+    EXPECT_EQ(static_cast<EventRecorder::time_type>(i + 10) * ms, records[i].stamp);
+  }
+
+  std::remove(path.c_str());
+}
+
+TEST(EventRecorder, SpansTheEvents)
+{
+  const auto path = tracePath();
+  {
+    EventRecorder recorder(path, 16);
+    // The handles are added stamped 0, before the events:
+    recorder.record(EventRecorder::ADD_VELOCITY, 0, 0, EventRecorder::NO_ID, 10, 0, 100 * ms);
+    recorder.record(EventRecorder::ADD_LOCK, 0, 1, EventRecorder::NO_ID, 20, 0, 0);
+    for (int i = 0; i < 5; ++i) {
+      recorder.record(EventRecorder::VELOCITY, (5000 + 50 * i) * ms, 0, 0, 0, 1);
+    }
+  }
+
+  const auto records = EventRecorder::read(path);
+  ASSERT_EQ(7u, records.size());
+  EXPECT_EQ(0, records.front().stamp);
+
+  ArbitrationEngine engine;
+  const auto result = twist_mux::replay(records, engine);
+  EXPECT_EQ(0u, result.mismatches);
+  EXPECT_EQ(200 * ms, result.span);
+
+  std::remove(path.c_str());
+}
+
+TEST(EventRecorder, RejectsOtherFiles)
+{
+  const auto path = tracePath();
+  {
+    std::FILE * file = std::fopen(path.c_str(), "w");
+    ASSERT_NE(nullptr, file);
+    std::fputs("not a trace", file);
+    std::fclose(file);
+  }
+
+  EXPECT_THROW(EventRecorder::read(path), std::runtime_error);
+  std::remove(path.c_str());
+}
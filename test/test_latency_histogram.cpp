@@ -0,0 +1,108 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+
+#include <twist_mux/latency_histogram.hpp>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using twist_mux::LatencyHistogram;
+
+TEST(LatencyHistogram, BucketsBoundTheirDurations)
+{
+  std::size_t previous = 0;
+  for (std::int64_t duration = 1; duration < (std::int64_t(1) << 40);
+    duration += duration / 7 + 1)
+  {
+    const auto bucket = LatencyHistogram::bucket(duration);
+    EXPECT_LE(previous, bucket);
+    EXPECT_LT(bucket, LatencyHistogram::BUCKETS);
+    EXPECT_LE(duration, LatencyHistogram::upperBound(bucket));
+    EXPECT_LT(LatencyHistogram::upperBound(bucket), duration + duration / 4 + 1);
+    previous = bucket;
+  }
+}
+
+TEST(LatencyHistogram, Percentiles)
+{
+  LatencyHistogram histogram;
+  for (std::int64_t duration = 1; duration <= 1000; ++duration) {
+    histogram.record(duration * 1000);
+  }
+
+  const auto snapshot = histogram.collect();
+  EXPECT_EQ(1000u, snapshot.total);
+  EXPECT_EQ(1000000, snapshot.max);
+  EXPECT_NEAR(500000, snapshot.percentile(0.5), 500000 / 4);
+  EXPECT_NEAR(990000, snapshot.percentile(0.99), 990000 / 4);
+  EXPECT_EQ(1000000, snapshot.percentile(1.0));
+}
+
+TEST(LatencyHistogram, CollectResets)
+{
+  LatencyHistogram histogram;
+  histogram.record(-5);
+  histogram.record(42);
+
+  auto snapshot = histogram.collect();
+  EXPECT_EQ(2u, snapshot.total);
+  EXPECT_EQ(1u, snapshot.counts[0]);
+  EXPECT_EQ(42, snapshot.max);
+
+  snapshot = histogram.collect();
+  EXPECT_EQ(0u, snapshot.total);
+  EXPECT_EQ(0, snapshot.max);
+  EXPECT_EQ(0, snapshot.percentile(0.99));
+}
+
+TEST(LatencyHistogram, ConcurrentRecords)
+{
+  constexpr int THREADS = 4;
+  constexpr int RECORDS = 10000;
+
+  LatencyHistogram histogram;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back(
+      [&histogram, t]() {
+        for (int i = 0; i < RECORDS; ++i) {
+          histogram.record(t * RECORDS + i);
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  const auto snapshot = histogram.collect();
+  EXPECT_EQ(static_cast<std::uint64_t>(THREADS * RECORDS), snapshot.total);
+  EXPECT_EQ(THREADS * RECORDS - 1, snapshot.max);
+}
@@ -0,0 +1,170 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+
+#include <twist_mux/status_mirror.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+using twist_mux::StatusMirror;
+using twist_mux::StatusMirrorReader;
+
+namespace
+{
+std::string segmentName()
+{
+  return "/test_status_mirror_" + std::to_string(::getpid());
+}
+}  // namespace
+
+TEST(StatusMirror, ReadsTheLastStatus)
+{
+  StatusMirror mirror(segmentName());
+  StatusMirrorReader reader(segmentName());
+
+  // The segment starts without winner:
+  StatusMirror::Status status;
+  ASSERT_TRUE(reader.tryRead(status));
+  EXPECT_EQ(1u, status.sequence);
+  EXPECT_EQ(StatusMirror::NO_ID, status.winner);
+
+  StatusMirror::Status update{};
+  update.winner = 3;
+  update.lock_priority = 100;
+  update.linear[0] = 0.5;
+  update.angular[2] = -1.0;
+  mirror.update(update);
+
+  ASSERT_TRUE(reader.tryRead(status));
+  EXPECT_EQ(2u, status.sequence);
+  EXPECT_EQ(update.heartbeat, status.heartbeat);
+  EXPECT_EQ(3u, status.winner);
+  EXPECT_EQ(100, status.lock_priority);
+  EXPECT_EQ(0.5, status.linear[0]);
+  EXPECT_EQ(-1.0, status.angular[2]);
+}
+
+TEST(StatusMirror, NeverReadsATornStatus)
+{
+  StatusMirror mirror(segmentName());
+  StatusMirrorReader reader(segmentName());
+
+  std::atomic<bool> done(false);
+  std::thread writer([&]() {
+      StatusMirror::Status status{};
+      for (int i = 0; i < 200000; ++i) {
+        // Every field derives from the same value:
+        status.winner = static_cast<std::uint32_t>(i);
+        status.lock_priority = i;
+        for (int axis = 0; axis < 3; ++axis) {
+          status.linear[axis] = i;
+          status.angular[axis] = -i;
+        }
+        mirror.update(status);
+      }
+      done = true;
+    });
+
+  std::uint64_t last_sequence = 0;
+  while (!done) {
+    // The writer may be preempted in the middle of an update for longer than
+    // the timeout, which is no torn read:
+    StatusMirror::Status status;
+    if (!reader.tryRead(status)) {
+      continue;
+    }
+    ASSERT_GE(status.sequence, last_sequence);
+    last_sequence = status.sequence;
+    if (status.winner == StatusMirror::NO_ID) {
+      continue;
+    }
+    ASSERT_EQ(static_cast<std::int32_t>(status.winner), status.lock_priority);
+    for (int axis = 0; axis < 3; ++axis) {
+      ASSERT_EQ(static_cast<double>(status.lock_priority), status.linear[axis]);
+      ASSERT_EQ(-status.linear[axis], status.angular[axis]);
+    }
+  }
+  writer.join();
+
+  StatusMirror::Status status;
+  ASSERT_TRUE(reader.tryRead(status));
+  EXPECT_EQ(200001u, status.sequence);
+}
+
+TEST(StatusMirror, GivesUpOnAnUnfinishedUpdate)
+{
+  StatusMirror mirror(segmentName());
+  StatusMirrorReader reader(segmentName());
+
+  StatusMirror::Status status;
+  ASSERT_TRUE(reader.tryRead(status));
+
+  // A writer which died in the middle of an update leaves the sequence odd:
+  const int fd = ::shm_open(segmentName().c_str(), O_RDWR, 0);
+  ASSERT_LE(0, fd);
+  void * mapping = ::mmap(
+    nullptr, sizeof(StatusMirror::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  ASSERT_NE(MAP_FAILED, mapping);
+  static_cast<StatusMirror::Segment *>(mapping)->lock.fetch_add(1);
+
+  StatusMirror::Status stale = status;
+  stale.sequence = 0;
+  EXPECT_FALSE(reader.tryRead(stale));
+  EXPECT_EQ(0u, stale.sequence);
+
+  // The next update ends it:
+  static_cast<StatusMirror::Segment *>(mapping)->lock.fetch_add(1);
+  ::munmap(mapping, sizeof(StatusMirror::Segment));
+  StatusMirror::Status update{};
+  mirror.update(update);
+  ASSERT_TRUE(reader.tryRead(status));
+  EXPECT_EQ(2u, status.sequence);
+}
+
+TEST(StatusMirror, RejectsOtherSegments)
+{
+  EXPECT_THROW(StatusMirrorReader reader(segmentName()), std::system_error);
+
+  const int fd = ::shm_open(segmentName().c_str(), O_RDWR | O_CREAT, 0644);
+  ASSERT_LE(0, fd);
+  ASSERT_EQ(0, ::ftruncate(fd, sizeof(StatusMirror::Segment)));
+  ::close(fd);
+
+  EXPECT_THROW(StatusMirrorReader reader(segmentName()), std::runtime_error);
+  ::shm_unlink(segmentName().c_str());
+}
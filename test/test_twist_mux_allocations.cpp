@@ -0,0 +1,273 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+
+#include "twist_mux_test_fixture.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+#include <geometry_msgs/msg/twist.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+
+#include <twist_mux/message_pool.hpp>
+#include <twist_mux/topic_handle.hpp>
+#include <twist_mux/twist_mux.hpp>
+#include <twist_mux/twist_output.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace
+{
+std::atomic<bool> counting(false);
+std::atomic<std::size_t> allocations(0);
+
+/**
+ * @brief The AllocationCounter class counts the heap allocations done by
+ * this process while it is alive.
+ */
+class AllocationCounter
+{
+public:
+  AllocationCounter()
+  {
+    allocations = 0;
+    counting = true;
+  }
+
+  ~AllocationCounter()
+  {
+    counting = false;
+  }
+
+  std::size_t count() const
+  {
+    return allocations;
+  }
+};
+}  // namespace
+
+void * operator new(std::size_t size)
+{
+  if (counting) {
+    ++allocations;
+  }
+  if (void * ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void * ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace
+{
+constexpr std::size_t WARM_UP = 10;
+constexpr std::size_t MESSAGES = 1000;
+
+/**
+ * @brief The CountingOutput class converts the commands as the real output
+ * does, without publishing, so the allocations of the middleware are not
+ * counted.
+ */
+class CountingOutput : public twist_mux::TwistOutputBase
+{
+public:
+  geometry_msgs::msg::Twist & prepare(const twist_mux::VelocityCommand & command) override
+  {
+    command.convert(out_);
+    return out_;
+  }
+
+  void stage() override
+  {
+    staged_ = true;
+  }
+
+  void flush() override
+  {
+    if (!staged_) {
+      return;
+    }
+    staged_ = false;
+
+    ++published_;
+    if (out_ == geometry_msgs::msg::Twist()) {
+      ++stops_;
+    }
+  }
+
+  std::size_t published_ = 0;
+  std::size_t stops_ = 0;
+
+private:
+  geometry_msgs::msg::Twist out_;
+  bool staged_ = false;
+};
+
+typedef twist_mux_test::TestTwistMux<CountingOutput> TestTwistMux;
+
+class TwistMuxAllocations : public twist_mux_test::TwistMuxTest
+{
+protected:
+  std::shared_ptr<TestTwistMux> createMux()
+  {
+    return TwistMuxTest::createMux<CountingOutput>(
+    {
+      {"topics.navigation.topic", "nav_vel"},
+      {"topics.navigation.timeout", 0.5},
+      {"topics.navigation.priority", 10},
+      {"topics.joystick.topic", "joy_vel"},
+      {"topics.joystick.timeout", 0.5},
+      {"topics.joystick.priority", 100},
+      {"locks.pause.topic", "pause"},
+      {"locks.pause.timeout", 0.0},
+      {"locks.pause.priority", 50},
+      {"locks.e_stop.topic", "e_stop"},
+      {"locks.e_stop.timeout", 0.0},
+      {"locks.e_stop.priority", 255},
+      {"failsafe.enabled", true},
+      {"memory_pool.enabled", true},
+    });
+  }
+};
+}  // namespace
+
+TEST_F(TwistMuxAllocations, ForwardingDoesNotAllocate)
+{
+  auto mux = createMux();
+  auto msg = std::make_shared<geometry_msgs::msg::Twist>();
+  msg->linear.x = 1.0;
+
+  for (std::size_t i = 0; i < WARM_UP; ++i) {
+    mux->forward(0, msg);
+  }
+
+  std::size_t count = 0;
+  {
+    AllocationCounter counter;
+    for (std::size_t i = 0; i < MESSAGES; ++i) {
+      mux->forward(0, msg);
+    }
+    count = counter.count();
+  }
+
+  EXPECT_EQ(0u, count);
+  EXPECT_EQ(WARM_UP + MESSAGES, mux->output().published_);
+}
+
+TEST_F(TwistMuxAllocations, ArbitrationDoesNotAllocate)
+{
+  auto mux = createMux();
+  auto msg = std::make_shared<geometry_msgs::msg::Twist>();
+  auto locked = std::make_shared<std_msgs::msg::Bool>();
+  msg->linear.x = 1.0;
+  auto free = std::make_shared<std_msgs::msg::Bool>();
+  locked->data = true;
+
+  // Switches of winner and lock state, after which every path has run once;
+  // the locks are in alphabetical order, e_stop masking the winner and
+  // publishing a stop, and pause only masking the other source:
+  auto cycle = [&]() {
+      mux->forward(0, msg);
+      mux->forward(1, msg);
+      mux->lock(1, locked);
+      mux->forward(0, msg);
+      mux->forward(1, msg);
+      mux->lock(0, locked);
+      mux->forward(0, msg);
+      mux->forward(1, msg);
+      mux->lock(0, free);
+      mux->lock(1, free);
+    };
+
+  for (std::size_t i = 0; i < WARM_UP; ++i) {
+    cycle();
+  }
+  const auto stops = mux->output().stops_;
+
+  std::size_t count = 0;
+  {
+    AllocationCounter counter;
+    for (std::size_t i = 0; i < MESSAGES; ++i) {
+      cycle();
+    }
+    count = counter.count();
+  }
+
+  EXPECT_EQ(0u, count);
+  // A stop each time e_stop masks the winner:
+  EXPECT_EQ(stops + MESSAGES, mux->output().stops_);
+}
+
+TEST(MessagePoolMemoryStrategy, BorrowingDoesNotAllocate)
+{
+  twist_mux::MessagePoolMemoryStrategy<geometry_msgs::msg::Twist> pool(4);
+
+  // A handle keeps the last message taken:
+  std::shared_ptr<geometry_msgs::msg::Twist> last;
+
+  std::size_t count = 0;
+  {
+    AllocationCounter counter;
+    for (std::size_t i = 0; i < MESSAGES; ++i) {
+      auto msg = pool.borrow_message();
+      last = msg;
+      pool.return_message(msg);
+    }
+    count = counter.count();
+  }
+
+  EXPECT_EQ(0u, count);
+}
+
+TEST(MessagePoolMemoryStrategy, AllocatesWhenExhausted)
+{
+  twist_mux::MessagePoolMemoryStrategy<geometry_msgs::msg::Twist> pool(2);
+
+  std::vector<std::shared_ptr<geometry_msgs::msg::Twist>> borrowed;
+  for (std::size_t i = 0; i < 3; ++i) {
+    borrowed.push_back(pool.borrow_message());
+  }
+
+  EXPECT_NE(borrowed[0], borrowed[1]);
+  EXPECT_NE(borrowed[1], borrowed[2]);
+  EXPECT_NE(borrowed[0], borrowed[2]);
+}
@@ -0,0 +1,496 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+
+#include "twist_mux_test_fixture.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+#include <geometry_msgs/msg/twist.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include <std_msgs/msg/bool.hpp>
+
+#include <twist_mux/params_helpers.hpp>
+#include <twist_mux/topic_handle.hpp>
+#include <twist_mux/twist_mux.hpp>
+#include <twist_mux/twist_output.hpp>
+#include <twist_mux/velocity_input.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace
+{
+/**
+ * @brief The RecordingOutput class keeps the commands published, instead of
+ * publishing them
+ */
+class RecordingOutput : public twist_mux::TwistOutputBase
+{
+public:
+  geometry_msgs::msg::Twist & prepare(const twist_mux::VelocityCommand & command) override
+  {
+    command.convert(prepared_);
+    return prepared_;
+  }
+
+  void stage() override
+  {
+    staged_ = prepared_;
+    has_staged_ = true;
+  }
+
+  void flush() override
+  {
+    if (has_staged_) {
+      published_.push_back(staged_);
+      has_staged_ = false;
+    }
+  }
+
+  std::vector<geometry_msgs::msg::Twist> published_;
+
+private:
+  geometry_msgs::msg::Twist prepared_;
+  geometry_msgs::msg::Twist staged_;
+  bool has_staged_ = false;
+};
+
+typedef twist_mux_test::TestTwistMux<RecordingOutput> TestTwistMux;
+
+class TwistMuxOutput : public twist_mux_test::TwistMuxTest
+{
+protected:
+  std::shared_ptr<TestTwistMux> createMux(std::vector<rclcpp::Parameter> parameters)
+  {
+    parameters.insert(
+      parameters.end(),
+    {
+      {"topics.joystick.topic", "joy_vel"},
+      {"topics.joystick.timeout", 0.5},
+      {"topics.joystick.priority", 100},
+      {"locks.e_stop.topic", "e_stop"},
+      {"locks.e_stop.timeout", 0.0},
+      {"locks.e_stop.priority", 255},
+    });
+    return TwistMuxTest::createMux<RecordingOutput>(parameters);
+  }
+};
+
+geometry_msgs::msg::Twist::ConstSharedPtr twist(double linear_x)
+{
+  auto msg = std::make_shared<geometry_msgs::msg::Twist>();
+  msg->linear.x = linear_x;
+  return msg;
+}
+
+std_msgs::msg::Bool::ConstSharedPtr lock(bool locked)
+{
+  auto msg = std::make_shared<std_msgs::msg::Bool>();
+  msg->data = locked;
+  return msg;
+}
+}  // namespace
+
+TEST_F(TwistMuxOutput, LockStopsBetweenRateLimitedTicks)
+{
+  // One output per second, so every command after the first is held back:
+  auto mux = createMux({{"output.max_rate", 1.0}});
+
+  mux->forward(0, twist(1.0));
+  mux->forward(0, twist(0.8));
+  ASSERT_EQ(1u, mux->output().published_.size());
+  EXPECT_EQ(1.0, mux->output().published_.back().linear.x);
+
+  // The lock masks every source, so no tick would ever publish the stop:
+  mux->lock(0, lock(true));
+  ASSERT_EQ(2u, mux->output().published_.size());
+  EXPECT_EQ(0.0, mux->output().published_.back().linear.x);
+
+  mux->tick();
+  mux->forward(0, twist(1.0));
+  mux->tick();
+  EXPECT_EQ(2u, mux->output().published_.size());
+  EXPECT_EQ(0.0, mux->output().published_.back().linear.x);
+}
+
+TEST_F(TwistMuxOutput, LockStopIsNotSmoothed)
+{
+  auto mux = createMux(
+  {
+    {"smoothing.enabled", true},
+    {"smoothing.max_acceleration.linear", std::vector<double>{0.1, 0.0, 0.0}},
+  });
+
+  // The first command ramps from a standstill:
+  mux->forward(0, twist(1.0));
+  ASSERT_FALSE(mux->output().published_.empty());
+  EXPECT_LT(0.0, mux->output().published_.back().linear.x);
+
+  mux->lock(0, lock(true));
+  EXPECT_EQ(0.0, mux->output().published_.back().linear.x);
+}
+
+TEST_F(TwistMuxOutput, ReconfigurationChangesTheWinner)
+{
+  auto mux = createMux(
+  {
+    {"topics.navigation.topic", "nav_vel"},
+    {"topics.navigation.timeout", 0.5},
+    {"topics.navigation.priority", 10},
+  });
+
+  // The handles are in alphabetical order, joystick then navigation:
+  mux->forward(1, twist(0.5));
+  mux->forward(0, twist(1.0));
+  mux->forward(1, twist(0.5));
+  ASSERT_EQ(2u, mux->output().published_.size());
+  EXPECT_EQ(1.0, mux->output().published_.back().linear.x);
+
+  // A new priority keeps the handle and its subscription:
+  const auto * navigation = &mux->velocityHandle(1);
+  ASSERT_TRUE(mux->reconfigure({{"topics.navigation.priority", 200}}));
+  EXPECT_EQ(navigation, &mux->velocityHandle(1));
+
+  mux->forward(0, twist(1.0));
+  mux->forward(1, twist(0.5));
+  mux->forward(0, twist(1.0));
+  EXPECT_EQ(0.5, mux->output().published_.back().linear.x);
+
+  // A new topic subscribes a new handle, which has received nothing yet:
+  ASSERT_TRUE(mux->reconfigure({{"topics.navigation.topic", "nav_vel_2"}}));
+  EXPECT_NE(navigation, &mux->velocityHandle(1));
+  EXPECT_EQ("nav_vel_2", mux->velocityHandle(1).getTopic());
+
+  mux->forward(0, twist(1.0));
+  EXPECT_EQ(1.0, mux->output().published_.back().linear.x);
+  mux->forward(1, twist(0.5));
+  mux->forward(0, twist(1.0));
+  EXPECT_EQ(0.5, mux->output().published_.back().linear.x);
+
+  // A new topic, between the two others:
+  ASSERT_TRUE(
+    mux->reconfigure(
+  {
+    {"topics.tablet.topic", "tablet_vel"},
+    {"topics.tablet.timeout", 0.5},
+    {"topics.tablet.priority", 250},
+  }));
+  ASSERT_EQ("topics.tablet", mux->velocityHandle(2).getName());
+
+  mux->forward(2, twist(0.2));
+  mux->forward(1, twist(0.5));
+  EXPECT_EQ(0.2, mux->output().published_.back().linear.x);
+
+  // A lock priority below the winner no longer masks it:
+  ASSERT_TRUE(mux->reconfigure({{"locks.e_stop.priority", 100}}));
+  mux->lock(0, lock(true));
+  mux->forward(2, twist(0.2));
+  EXPECT_EQ(0.2, mux->output().published_.back().linear.x);
+  mux->forward(0, twist(1.0));
+  EXPECT_EQ(0.2, mux->output().published_.back().linear.x);
+}
+
+TEST_F(TwistMuxOutput, NestedParametersAreNotTopics)
+{
+  auto mux = createMux(
+  {
+    {"topics.navigation.topic", "nav_vel"},
+    {"topics.navigation.timeout", 0.5},
+    {"topics.navigation.priority", 10},
+    {"topics.navigation.qos.depth", 1},
+    {"topics.navigation.qos.reliability", "best_effort"},
+  });
+
+  EXPECT_EQ("topics.navigation", mux->velocityHandle(1).getName());
+  const auto & qos = mux->velocityHandle(1).getQoS();
+  EXPECT_EQ(1u, qos.depth());
+  EXPECT_EQ(rclcpp::ReliabilityPolicy::BestEffort, qos.reliability());
+
+  mux->forward(1, twist(0.5));
+  EXPECT_EQ(0.5, mux->output().published_.back().linear.x);
+}
+
+TEST_F(TwistMuxOutput, FailsafeOnExpiry)
+{
+  auto mux = createMux(
+  {
+    {"failsafe.enabled", true},
+    {"failsafe.linear", std::vector<double>{-0.1, 0.0, 0.0}},
+    {"topics.navigation.topic", "nav_vel"},
+    {"topics.navigation.timeout", 0.05},
+    {"topics.navigation.priority", 10},
+  });
+
+  mux->forward(1, twist(0.5));
+  ASSERT_EQ(1u, mux->output().published_.size());
+
+  // No other source has received anything, so the fail-safe command is
+  // published on the first tick past the deadline:
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  mux->tick();
+  ASSERT_EQ(2u, mux->output().published_.size());
+  EXPECT_EQ(-0.1, mux->output().published_.back().linear.x);
+
+  // The latency of that handover, from the deadline to the tick:
+  mux->updateDiagnostics();
+  EXPECT_LT(0.0, mux->status().handover_latency);
+  EXPECT_GT(1.0, mux->status().handover_latency);
+  EXPECT_EQ(mux->status().handover_latency, mux->status().max_handover_latency);
+}
+
+TEST_F(TwistMuxOutput, HandoverToTheNextSource)
+{
+  auto mux = createMux(
+  {
+    {"failsafe.enabled", true},
+    {"topics.docking.topic", "dock_vel"},
+    {"topics.docking.timeout", 0.0},
+    {"topics.docking.priority", 20},
+    {"topics.navigation.topic", "nav_vel"},
+    {"topics.navigation.timeout", 0.05},
+    {"topics.navigation.priority", 50},
+  });
+
+  // docking, joystick then navigation:
+  mux->forward(0, twist(0.2));
+  mux->forward(2, twist(0.5));
+  ASSERT_EQ(0.5, mux->output().published_.back().linear.x);
+
+  // The last command of docking, which never expires, is published again:
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  mux->tick();
+  ASSERT_EQ(3u, mux->output().published_.size());
+  EXPECT_EQ(0.2, mux->output().published_.back().linear.x);
+}
+
+TEST_F(TwistMuxOutput, DeadlineEventHandsOver)
+{
+  auto mux = createMux(
+  {
+    {"failsafe.enabled", true},
+    {"topics.docking.topic", "dock_vel"},
+    {"topics.docking.timeout", 0.0},
+    {"topics.docking.priority", 20},
+    {"topics.navigation.topic", "nav_vel"},
+    {"topics.navigation.timeout", 10.0},
+    {"topics.navigation.priority", 50},
+  });
+
+  mux->forward(0, twist(0.2));
+  mux->forward(2, twist(0.5));
+  ASSERT_EQ(0.5, mux->output().published_.back().linear.x);
+
+  // A missed QoS deadline expires navigation long before its timeout, and
+  // hands over without waiting for a tick:
+  mux->expire(mux->velocityHandle(2).getId());
+  ASSERT_EQ(3u, mux->output().published_.size());
+  EXPECT_EQ(0.2, mux->output().published_.back().linear.x);
+
+  // Until it receives again:
+  mux->forward(2, twist(0.5));
+  EXPECT_EQ(0.5, mux->output().published_.back().linear.x);
+}
+
+TEST_F(TwistMuxOutput, FixedRateOutput)
+{
+  auto mux = createMux({{"output.rate", 100.0}});
+
+  // Only the output timer publishes, and it publishes the winner again each
+  // period:
+  mux->forward(0, twist(1.0));
+  EXPECT_TRUE(mux->output().published_.empty());
+
+  ASSERT_TRUE(mux->spinUntil([&mux]() {return mux->output().published_.size() >= 3;}));
+  for (const auto & published : mux->output().published_) {
+    EXPECT_EQ(1.0, published.linear.x);
+  }
+}
+
+TEST_F(TwistMuxOutput, DeduplicatedOutput)
+{
+  auto mux = createMux({{"output.deduplicate", true}});
+
+  mux->forward(0, twist(1.0));
+  mux->forward(0, twist(1.0));
+  mux->forward(0, twist(1.0));
+  EXPECT_EQ(1u, mux->output().published_.size());
+
+  mux->forward(0, twist(0.5));
+  mux->forward(0, twist(0.5));
+  ASSERT_EQ(2u, mux->output().published_.size());
+  EXPECT_EQ(0.5, mux->output().published_.back().linear.x);
+}
+
+TEST_F(TwistMuxOutput, GroupsArbitrateAmongThemselves)
+{
+  auto mux = createMux(
+  {
+    {"groups.planners.priority", 150},
+    {"topics.local.topic", "local_vel"},
+    {"topics.local.timeout", 0.5},
+    {"topics.local.priority", 20},
+    {"topics.local.group", "planners"},
+    {"topics.global.topic", "global_vel"},
+    {"topics.global.timeout", 0.5},
+    {"topics.global.priority", 10},
+    {"topics.global.group", "planners"},
+  });
+
+  // global, joystick then local; the group competes with its priority,
+  // above the one of joystick:
+  mux->forward(1, twist(1.0));
+  EXPECT_EQ(1.0, mux->output().published_.back().linear.x);
+  mux->forward(0, twist(0.1));
+  EXPECT_EQ(0.1, mux->output().published_.back().linear.x);
+
+  // Within the group, the priority of the handle:
+  mux->forward(2, twist(0.2));
+  EXPECT_EQ(0.2, mux->output().published_.back().linear.x);
+  mux->forward(0, twist(0.1));
+  mux->forward(1, twist(1.0));
+  EXPECT_EQ(0.2, mux->output().published_.back().linear.x);
+
+  // A lock above the group stops it:
+  mux->lock(0, lock(true));
+  EXPECT_EQ(0.0, mux->output().published_.back().linear.x);
+}
+
+TEST_F(TwistMuxOutput, ActiveSourceFollowsTheWinner)
+{
+  auto mux = createMux(
+  {
+    {"topics.navigation.topic", "nav_vel"},
+    {"topics.navigation.timeout", 0.5},
+    {"topics.navigation.priority", 10},
+  });
+
+  mux->forward(1, twist(0.5));
+  EXPECT_EQ("topics.navigation", mux->activeSource().name);
+  EXPECT_EQ(1, mux->activeSource().id);
+  EXPECT_EQ(10, mux->activeSource().priority);
+  EXPECT_EQ(0, mux->activeSource().lock_priority);
+
+  mux->forward(0, twist(1.0));
+  EXPECT_EQ("topics.joystick", mux->activeSource().name);
+  EXPECT_EQ(0, mux->activeSource().id);
+  EXPECT_EQ(100, mux->activeSource().priority);
+
+  // The lock masks every source:
+  mux->lock(0, lock(true));
+  EXPECT_EQ("", mux->activeSource().name);
+  EXPECT_EQ(-1, mux->activeSource().id);
+  EXPECT_EQ(255, mux->activeSource().lock_priority);
+
+  mux->lock(0, lock(false));
+  mux->forward(0, twist(1.0));
+  EXPECT_EQ("topics.joystick", mux->activeSource().name);
+  EXPECT_EQ(0, mux->activeSource().lock_priority);
+}
+
+TEST_F(TwistMuxOutput, MaskedQoSWhileLocked)
+{
+  auto mux = createMux(
+  {
+    {"topics.navigation.topic", "nav_vel"},
+    {"topics.navigation.timeout", 0.0},
+    {"topics.navigation.priority", 10},
+    {"topics.navigation.qos.depth", 10},
+    {"topics.navigation.masked_qos.enabled", true},
+  });
+
+  const auto & navigation = mux->velocityHandle(1);
+  ASSERT_TRUE(navigation.getMaskedQoS());
+  EXPECT_EQ(1u, navigation.getMaskedQoS()->depth());
+  EXPECT_EQ(rclcpp::ReliabilityPolicy::BestEffort, navigation.getMaskedQoS()->reliability());
+  EXPECT_EQ(10u, navigation.getQoS().depth());
+
+  mux->forward(1, twist(0.5));
+  mux->updateDiagnostics();
+  EXPECT_FALSE(navigation.hasMaskedSubscription());
+
+  // Masked for two updates in a row:
+  mux->lock(0, lock(true));
+  mux->updateDiagnostics();
+  EXPECT_FALSE(navigation.hasMaskedSubscription());
+  mux->updateDiagnostics();
+  EXPECT_TRUE(navigation.hasMaskedSubscription());
+
+  // Unmasked at the next update, and still received:
+  mux->lock(0, lock(false));
+  mux->updateDiagnostics();
+  EXPECT_FALSE(navigation.hasMaskedSubscription());
+  mux->forward(1, twist(0.3));
+  EXPECT_EQ(0.3, mux->output().published_.back().linear.x);
+}
+
+TEST_F(TwistMuxOutput, CompiledConfiguration)
+{
+  const auto & type = twist_mux::VelocityInputTraits<geometry_msgs::msg::Twist>::type;
+  twist_mux::TwistMux::Configuration configuration;
+  configuration.velocities = {
+    {"topics.joystick", "joy_vel", 0.5, 100, type, "",
+      rclcpp::SystemDefaultsQoS(), std::nullopt},
+    {"topics.navigation", "nav_vel", 0.5, 10, type, "",
+      rclcpp::SystemDefaultsQoS(), std::nullopt},
+  };
+  configuration.locks = {
+    {"locks.e_stop", "e_stop", 0.0, 255, "", "", rclcpp::SystemDefaultsQoS(), std::nullopt},
+  };
+  ASSERT_NO_THROW(twist_mux::TwistMux::validate(configuration));
+
+  auto mux = TwistMuxTest::createMux<RecordingOutput>(configuration);
+  ASSERT_EQ("nav_vel", mux->velocityHandle(1).getTopic());
+
+  mux->forward(1, twist(0.5));
+  mux->forward(0, twist(1.0));
+  mux->forward(1, twist(0.5));
+  EXPECT_EQ(1.0, mux->output().published_.back().linear.x);
+  mux->lock(0, lock(true));
+  EXPECT_EQ(0.0, mux->output().published_.back().linear.x);
+
+  // The parameters do not change it:
+  EXPECT_FALSE(mux->reconfigure({{"topics.navigation.priority", 200}}));
+
+  // The checks of the parameters:
+  auto invalid = configuration;
+  invalid.velocities[1].group = "planners";
+  EXPECT_THROW(twist_mux::TwistMux::validate(invalid), twist_mux::ParamsHelperException);
+  invalid = configuration;
+  invalid.velocities[1].type = "geometry_msgs/msg/Accel";
+  EXPECT_THROW(twist_mux::TwistMux::validate(invalid), twist_mux::ParamsHelperException);
+  invalid = configuration;
+  invalid.locks[0].name = "topics.joystick";
+  EXPECT_THROW(twist_mux::TwistMux::validate(invalid), twist_mux::ParamsHelperException);
+  EXPECT_THROW(
+    TwistMuxTest::createMux<RecordingOutput>(invalid), twist_mux::ParamsHelperException);
+}
@@ -0,0 +1,127 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+
+#include <twist_mux/velocity_control.hpp>
+
+#include <geometry_msgs/msg/twist.hpp>
+
+#include <stdexcept>
+
+using twist_mux::Velocity;
+using twist_mux::VelocityControl;
+
+namespace
+{
+geometry_msgs::msg::Twist twist(double linear_x, double linear_y, double angular_z)
+{
+  geometry_msgs::msg::Twist twist;
+  twist.linear.x = linear_x;
+  twist.linear.y = linear_y;
+  twist.angular.z = angular_z;
+  return twist;
+}
+
+/// Turbo of config/joystick.yaml:
+VelocityControl joystick(int init_step = 2)
+{
+  return VelocityControl(
+    4, init_step, Velocity(0.5, 1.0, 4), Velocity(0.25, 0.5, 4), Velocity(1.0, 1.0, 4),
+    Velocity(0.7, 1.2, 4));
+}
+}  // namespace
+
+TEST(Velocity, GrowsLinearlyWithTheStep)
+{
+  const Velocity velocity(0.5, 1.0, 3);
+
+  EXPECT_DOUBLE_EQ(0.25, velocity(0.5, 1));
+  EXPECT_DOUBLE_EQ(-0.75, velocity(-1.0, 2));
+  EXPECT_DOUBLE_EQ(1.0, velocity(1.0, 3));
+
+  // A single step always uses the minimum velocity:
+  EXPECT_DOUBLE_EQ(0.5, Velocity(0.5, 1.0, 1)(1.0, 1));
+
+  EXPECT_THROW(Velocity(0.0, 1.0, 3), std::invalid_argument);
+  EXPECT_THROW(Velocity(0.5, 1.0, 0), std::invalid_argument);
+}
+
+TEST(VelocityControl, ScalesWithTheTurboSteps)
+{
+  auto control = joystick();
+  geometry_msgs::msg::Twist scaled;
+
+  ASSERT_TRUE(control.scaleTwist(twist(1.0, 0.5, -1.0), scaled));
+  EXPECT_NEAR(2.0 / 3.0, scaled.linear.x, 1e-9);
+  EXPECT_DOUBLE_EQ(0.5, scaled.linear.y);
+  EXPECT_NEAR(-(0.7 + 0.5 / 3.0), scaled.angular.z, 1e-9);
+
+  // Backwards uses its own velocity:
+  ASSERT_TRUE(control.scaleTwist(twist(-1.0, 0.0, 0.0), scaled));
+  EXPECT_NEAR(-(0.25 + 0.25 / 3.0), scaled.linear.x, 1e-9);
+
+  control.increaseTurbo();
+  control.increaseTurbo();
+  control.increaseTurbo();
+  EXPECT_EQ(4, control.getStep());
+  EXPECT_EQ(4, control.getAngularStep());
+  ASSERT_TRUE(control.scaleTwist(twist(1.0, 0.0, 1.0), scaled));
+  EXPECT_DOUBLE_EQ(1.0, scaled.linear.x);
+  EXPECT_DOUBLE_EQ(1.2, scaled.angular.z);
+
+  // The angular step moves alone, and both stay in range:
+  for (int i = 0; i < 5; ++i) {
+    control.decreaseAngularTurbo();
+  }
+  EXPECT_EQ(4, control.getStep());
+  EXPECT_EQ(1, control.getAngularStep());
+  control.decreaseTurbo();
+  EXPECT_EQ(3, control.getStep());
+  EXPECT_EQ(1, control.getAngularStep());
+
+  control.resetTurbo();
+  EXPECT_EQ(2, control.getStep());
+  EXPECT_EQ(2, control.getAngularStep());
+
+  EXPECT_THROW(joystick(5), std::invalid_argument);
+}
+
+TEST(VelocityControl, RejectsInvalidTwists)
+{
+  const auto control = joystick();
+  geometry_msgs::msg::Twist scaled;
+
+  EXPECT_FALSE(control.scaleTwist(twist(1.5, 0.0, 0.0), scaled));
+  EXPECT_EQ(geometry_msgs::msg::Twist(), scaled);
+
+  auto cmd = twist(0.5, 0.0, 0.0);
+  cmd.angular.x = 0.1;
+  EXPECT_FALSE(control.scaleTwist(cmd, scaled));
+  EXPECT_EQ(geometry_msgs::msg::Twist(), scaled);
+}
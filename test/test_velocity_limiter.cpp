@@ -0,0 +1,121 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+
+#include <twist_mux/velocity_limiter.hpp>
+
+#include <geometry_msgs/msg/twist.hpp>
+
+using twist_mux::VelocityLimiter;
+
+namespace
+{
+constexpr double dt = 0.01;
+
+geometry_msgs::msg::Twist twist(double linear_x, double angular_z)
+{
+  geometry_msgs::msg::Twist twist;
+  twist.linear.x = linear_x;
+  twist.angular.z = angular_z;
+  return twist;
+}
+}  // namespace
+
+TEST(VelocityLimiter, UnlimitedAxesPassThrough)
+{
+  VelocityLimiter limiter({}, {});
+
+  auto command = twist(1.0, -2.0);
+  EXPECT_FALSE(limiter.limit(command, twist(0.0, 0.0), dt));
+  EXPECT_EQ(twist(1.0, -2.0), command);
+}
+
+TEST(VelocityLimiter, LimitsAcceleration)
+{
+  VelocityLimiter limiter({1.0, 0, 0, 0, 0, 2.0}, {});
+
+  auto last = twist(0.0, 0.0);
+  for (int i = 0; i < 50; ++i) {
+    auto command = twist(1.0, -1.0);
+    EXPECT_TRUE(limiter.limit(command, last, dt));
+    EXPECT_NEAR(last.linear.x + 1.0 * dt, command.linear.x, 1e-9);
+    EXPECT_NEAR(last.angular.z - 2.0 * dt, command.angular.z, 1e-9);
+    last = command;
+  }
+
+  // 1 s at 1 m/s^2 reaches the command:
+  for (int i = 0; i < 60; ++i) {
+    auto command = twist(1.0, -1.0);
+    limiter.limit(command, last, dt);
+    last = command;
+  }
+  EXPECT_DOUBLE_EQ(1.0, last.linear.x);
+  EXPECT_DOUBLE_EQ(-1.0, last.angular.z);
+}
+
+TEST(VelocityLimiter, LimitsJerkWithoutOvershoot)
+{
+  VelocityLimiter limiter({}, {10.0, 0, 0, 0, 0, 0});
+
+  auto last = twist(0.0, 0.0);
+  double acceleration = 0.0;
+  for (int i = 0; i < 200; ++i) {
+    auto command = twist(1.0, 0.0);
+    limiter.limit(command, last, dt);
+
+    const double new_acceleration = (command.linear.x - last.linear.x) / dt;
+    EXPECT_LE(new_acceleration - acceleration, 10.0 * dt + 1e-9);
+    EXPECT_LE(command.linear.x, 1.0);
+
+    acceleration = new_acceleration;
+    last = command;
+  }
+  EXPECT_DOUBLE_EQ(1.0, last.linear.x);
+}
+
+TEST(VelocityLimiter, BrakesWithoutLimit)
+{
+  VelocityLimiter limiter({1.0, 0, 0, 0, 0, 2.0}, {});
+
+  // Slowing down towards zero passes at once:
+  auto command = twist(0.0, -0.5);
+  EXPECT_FALSE(limiter.limit(command, twist(1.0, -1.0), dt, true));
+  EXPECT_EQ(twist(0.0, -0.5), command);
+
+  // Not speeding up, nor reversing:
+  command = twist(-1.0, -2.0);
+  EXPECT_TRUE(limiter.limit(command, twist(1.0, -1.0), dt, true));
+  EXPECT_NEAR(1.0 - 1.0 * dt, command.linear.x, 1e-9);
+  EXPECT_NEAR(-1.0 - 2.0 * dt, command.angular.z, 1e-9);
+
+  // Without braking, slowing down is limited too:
+  command = twist(0.0, 0.0);
+  EXPECT_TRUE(limiter.limit(command, twist(1.0, -1.0), dt));
+  EXPECT_NEAR(1.0 - 1.0 * dt, command.linear.x, 1e-9);
+}
@@ -0,0 +1,414 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <benchmark/benchmark.h>
+
+#include <rclcpp/rclcpp.hpp>
+#include <std_msgs/msg/bool.hpp>
+#include <geometry_msgs/msg/twist.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+
+#include <twist_mux/twist_mux.hpp>
+
+#include <diagnostic_updater/diagnostic_updater.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Input to output latency and throughput of the mux, driven in-process
+ * (intra-process communication, single-threaded executor) by synthetic
+ * publishers:
+ *
+ * - velocity_topics : velocity sources, the last one having the highest
+ *                     priority, so every cycle runs both the masked and the
+ *                     winner path of hasPriority()
+ * - lock_topics     : free locks, published once per burst
+ * - burst           : messages published by each source before spinning,
+ *                     i.e. the publish rate relative to the executor
+ *
+ * Each message carries its sequence number and send time, in linear.y and
+ * linear.z, so the latency is measured from the publish of an input to the
+ * callback of the output subscriber.
+ *
+ * The lock reaction is the time from the publish of a lock that masks the
+ * winner to the stop on the output, with no velocity message in between.
+ * The within_bound counter is the share of the reactions shorter than the
+ * expiry check period, i.e. that did not wait for anything but the lock
+ * callback; it is a measurement, not a check, so that a loaded host does
+ * not fail the benchmark.
+ *
+ * The memory of a mux is the growth of the resident set of the process per
+ * mux created, each with two velocity topics and a lock in the namespace of
+ * a robot, as twist_mux_multi creates them: either with timers and a
+ * diagnostics updater of its own, or hosted, sharing those of the process.
+ */
+
+namespace
+{
+typedef geometry_msgs::msg::Twist Unstamped;
+typedef geometry_msgs::msg::TwistStamped Stamped;
+
+/// Expiry check period of the mux:
+constexpr std::chrono::milliseconds LOCK_REACTION_BOUND(10);
+
+double nowNs()
+{
+  return static_cast<double>(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+Unstamped & twistOf(Unstamped & msg)
+{
+  return msg;
+}
+
+Unstamped & twistOf(Stamped & msg)
+{
+  return msg.twist;
+}
+
+const Unstamped & twistOf(const Unstamped & msg)
+{
+  return msg;
+}
+
+const Unstamped & twistOf(const Stamped & msg)
+{
+  return msg.twist;
+}
+
+double percentile(std::vector<double> & samples, double q)
+{
+  if (samples.empty()) {
+    return 0.0;
+  }
+  const auto n = std::min(
+    samples.size() - 1, static_cast<std::size_t>(q * static_cast<double>(samples.size())));
+  std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+  return samples[n];
+}
+
+/**
+ * @brief residentBytes Resident set size of the process
+ */
+double residentBytes()
+{
+  std::ifstream statm("/proc/self/statm");
+  std::size_t size = 0, resident = 0;
+  statm >> size >> resident;
+  return static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE));
+}
+
+template<typename OutputT>
+class Sink : public rclcpp::Node
+{
+public:
+  explicit Sink(const rclcpp::NodeOptions & options)
+  : Node("twist_mux_benchmark_sink", options),
+    last_sequence_(0)
+  {
+    sub_ = create_subscription<OutputT>(
+      "cmd_vel_out", rclcpp::QoS(rclcpp::KeepLast(100)),
+      [this](const typename OutputT::ConstSharedPtr msg) {
+        const auto & twist = twistOf(*msg);
+        latencies_.push_back(nowNs() - twist.linear.z);
+        last_sequence_ = twist.linear.y;
+        last_received_ = nowNs();
+        last_x_ = twist.linear.x;
+      });
+  }
+
+  std::vector<double> latencies_;
+  double last_sequence_;
+
+  /// Reception time and linear x of the last command:
+  double last_received_ = 0.0;
+  double last_x_ = 0.0;
+
+private:
+  typename rclcpp::Subscription<OutputT>::SharedPtr sub_;
+};
+
+rclcpp::NodeOptions muxOptions(
+  std::int64_t velocity_topics, std::int64_t lock_topics, bool input_stamped,
+  bool output_stamped)
+{
+  std::vector<rclcpp::Parameter> parameters;
+  for (std::int64_t i = 0; i < velocity_topics; ++i) {
+    const auto prefix = "topics.input_" + std::to_string(i);
+    parameters.emplace_back(prefix + ".topic", "input_" + std::to_string(i));
+    parameters.emplace_back(prefix + ".timeout", 0.5);
+    parameters.emplace_back(prefix + ".priority", static_cast<int>(i + 1));
+    parameters.emplace_back(prefix + ".stamped", input_stamped);
+  }
+  for (std::int64_t i = 0; i < lock_topics; ++i) {
+    const auto prefix = "locks.lock_" + std::to_string(i);
+    parameters.emplace_back(prefix + ".topic", "lock_" + std::to_string(i));
+    parameters.emplace_back(prefix + ".timeout", 0.0);
+    parameters.emplace_back(prefix + ".priority", static_cast<int>(255 - i));
+  }
+  parameters.emplace_back("output_stamped", output_stamped);
+
+  rclcpp::NodeOptions options;
+  options.use_intra_process_comms(true);
+  options.parameter_overrides(parameters);
+  return options;
+}
+
+template<typename InputT, bool OutputStamped>
+void BM_Forwarding(benchmark::State & state)
+{
+  typedef std::conditional_t<OutputStamped, Stamped, Unstamped> OutputT;
+
+  const auto velocity_topics = state.range(0);
+  const auto lock_topics = state.range(1);
+  const auto burst = state.range(2);
+
+  if (!rclcpp::ok()) {
+    rclcpp::init(0, nullptr);
+  }
+
+  rclcpp::NodeOptions options;
+  options.use_intra_process_comms(true);
+
+  auto mux = std::make_shared<twist_mux::TwistMux>(
+    muxOptions(velocity_topics, lock_topics, std::is_same_v<InputT, Stamped>, OutputStamped));
+  auto driver = std::make_shared<rclcpp::Node>("twist_mux_benchmark_driver", options);
+  auto sink = std::make_shared<Sink<OutputT>>(options);
+
+  std::vector<typename rclcpp::Publisher<InputT>::SharedPtr> velocity_pubs;
+  for (std::int64_t i = 0; i < velocity_topics; ++i) {
+    velocity_pubs.push_back(
+      driver->create_publisher<InputT>("input_" + std::to_string(i), rclcpp::SystemDefaultsQoS()));
+  }
+
+  std::vector<rclcpp::Publisher<std_msgs::msg::Bool>::SharedPtr> lock_pubs;
+  for (std::int64_t i = 0; i < lock_topics; ++i) {
+    lock_pubs.push_back(
+      driver->create_publisher<std_msgs::msg::Bool>(
+        "lock_" + std::to_string(i), rclcpp::SystemDefaultsQoS()));
+  }
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(mux);
+  executor.add_node(driver);
+  executor.add_node(sink);
+
+  InputT msg;
+  std_msgs::msg::Bool lock_msg;
+  lock_msg.data = false;
+  double sequence = 0;
+
+  auto cycle = [&]() {
+      for (std::int64_t b = 0; b < burst; ++b) {
+        sequence += 1;
+        for (const auto & pub : lock_pubs) {
+          pub->publish(lock_msg);
+        }
+        // In increasing priority, so the winner is the last one:
+        for (const auto & pub : velocity_pubs) {
+          twistOf(msg).linear.y = sequence;
+          twistOf(msg).linear.z = nowNs();
+          pub->publish(msg);
+        }
+      }
+
+      while (sink->last_sequence_ < sequence && rclcpp::ok()) {
+        executor.spin_some();
+      }
+    };
+
+  // Warm up the subscriptions, the arbitration cache and the queues:
+  for (int i = 0; i < 100; ++i) {
+    cycle();
+  }
+  sink->latencies_.clear();
+  sink->latencies_.reserve(1 << 20);
+
+  for (auto _ : state) {
+    cycle();
+  }
+
+  state.SetItemsProcessed(state.iterations() * burst * (velocity_topics + lock_topics));
+
+  state.counters["forwarded"] = static_cast<double>(sink->latencies_.size());
+  state.counters["p50_us"] = 1e-3 * percentile(sink->latencies_, 0.5);
+  state.counters["p99_us"] = 1e-3 * percentile(sink->latencies_, 0.99);
+  state.counters["p99.9_us"] = 1e-3 * percentile(sink->latencies_, 0.999);
+}
+
+void BM_LockReaction(benchmark::State & state)
+{
+  if (!rclcpp::ok()) {
+    rclcpp::init(0, nullptr);
+  }
+
+  rclcpp::NodeOptions options;
+  options.use_intra_process_comms(true);
+
+  auto mux = std::make_shared<twist_mux::TwistMux>(muxOptions(1, 1, false, false));
+  auto driver = std::make_shared<rclcpp::Node>("twist_mux_benchmark_driver", options);
+  auto sink = std::make_shared<Sink<Unstamped>>(options);
+
+  auto velocity_pub = driver->create_publisher<Unstamped>("input_0", rclcpp::SystemDefaultsQoS());
+  auto lock_pub = driver->create_publisher<std_msgs::msg::Bool>(
+    "lock_0", rclcpp::SystemDefaultsQoS());
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(mux);
+  executor.add_node(driver);
+  executor.add_node(sink);
+
+  Unstamped msg;
+  msg.linear.x = 1.0;
+  std_msgs::msg::Bool lock_msg;
+  double sequence = 0;
+
+  // Spins until the output has linear x, false on a timeout:
+  auto spinUntil = [&](double x) {
+      const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+      while (sink->last_x_ != x && rclcpp::ok()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+          return false;
+        }
+        executor.spin_some();
+      }
+      return true;
+    };
+
+  std::vector<double> reactions;
+  reactions.reserve(1 << 16);
+  for (auto _ : state) {
+    // Release the lock, and let the velocity win:
+    lock_msg.data = false;
+    lock_pub->publish(lock_msg);
+    sequence += 1;
+    msg.linear.y = sequence;
+    msg.linear.z = nowNs();
+    velocity_pub->publish(msg);
+    if (!spinUntil(msg.linear.x)) {
+      state.SkipWithError("the velocity is not forwarded");
+      break;
+    }
+
+    lock_msg.data = true;
+    const auto start = nowNs();
+    lock_pub->publish(lock_msg);
+    if (!spinUntil(0.0)) {
+      state.SkipWithError("no stop after the lock");
+      break;
+    }
+    reactions.push_back(sink->last_received_ - start);
+  }
+
+  const auto max_reaction = reactions.empty() ?
+    0.0 : *std::max_element(reactions.begin(), reactions.end());
+  const auto bound = std::chrono::duration<double, std::nano>(LOCK_REACTION_BOUND).count();
+  const auto within_bound = std::count_if(
+    reactions.begin(), reactions.end(), [bound](double reaction) {return reaction < bound;});
+
+  state.counters["p50_us"] = 1e-3 * percentile(reactions, 0.5);
+  state.counters["p99_us"] = 1e-3 * percentile(reactions, 0.99);
+  state.counters["max_us"] = 1e-3 * max_reaction;
+  state.counters["within_bound"] = reactions.empty() ?
+    0.0 : static_cast<double>(within_bound) / static_cast<double>(reactions.size());
+}
+
+void BM_MuxMemory(benchmark::State & state)
+{
+  const auto instances = state.range(0);
+  const bool hosted = state.range(1) != 0;
+
+  if (!rclcpp::ok()) {
+    rclcpp::init(0, nullptr);
+  }
+
+  // Measured once, as the memory freed by the muxes of a run would be
+  // reused by the next:
+  double growth = 0.0;
+  for (auto _ : state) {
+    auto host = std::make_shared<rclcpp::Node>("twist_mux_benchmark_host");
+    auto diagnostics = hosted ? std::make_shared<diagnostic_updater::Updater>(host) : nullptr;
+
+    std::vector<std::shared_ptr<twist_mux::TwistMux>> muxes;
+    muxes.reserve(static_cast<std::size_t>(instances));
+    const auto before = residentBytes();
+    for (std::int64_t i = 0; i < instances; ++i) {
+      auto options = muxOptions(2, 1, false, false)
+        .use_intra_process_comms(false)
+        .arguments({"--ros-args", "-r", "__ns:=/robot_" + std::to_string(i)})
+        .start_parameter_services(false)
+        .start_parameter_event_publisher(false)
+        .enable_rosout(false);
+      muxes.push_back(
+        hosted ? std::make_shared<twist_mux::TwistMux>(options, diagnostics) :
+        std::make_shared<twist_mux::TwistMux>(options));
+    }
+    growth = residentBytes() - before;
+  }
+
+  state.counters["rss_per_instance_kB"] = 1e-3 * growth / static_cast<double>(instances);
+}
+
+void memoryArguments(benchmark::internal::Benchmark * b)
+{
+  b->ArgNames({"instances", "hosted"});
+  for (int instances : {1, 10, 50}) {
+    for (int hosted : {0, 1}) {
+      b->Args({instances, hosted});
+    }
+  }
+}
+
+void forwardingArguments(benchmark::internal::Benchmark * b)
+{
+  b->ArgNames({"velocity_topics", "lock_topics", "burst"});
+  for (int velocity_topics : {1, 4, 16, 32}) {
+    for (int lock_topics : {0, 4, 16}) {
+      for (int burst : {1, 8}) {
+        b->Args({velocity_topics, lock_topics, burst});
+      }
+    }
+  }
+}
+}  // namespace
+
+BENCHMARK_TEMPLATE2(BM_Forwarding, Unstamped, false)->Apply(forwardingArguments)->UseRealTime();
+BENCHMARK_TEMPLATE2(BM_Forwarding, Unstamped, true)->Apply(forwardingArguments)->UseRealTime();
+BENCHMARK_TEMPLATE2(BM_Forwarding, Stamped, false)->Apply(forwardingArguments)->UseRealTime();
+BENCHMARK_TEMPLATE2(BM_Forwarding, Stamped, true)->Apply(forwardingArguments)->UseRealTime();
+BENCHMARK(BM_LockReaction)->UseRealTime();
+BENCHMARK(BM_MuxMemory)->Apply(memoryArguments)->Iterations(1)->UseRealTime();
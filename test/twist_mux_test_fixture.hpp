@@ -0,0 +1,207 @@
+// Copyright 2026 PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the PAL Robotics S.L. nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TEST__TWIST_MUX_TEST_FIXTURE_HPP_
+#define TEST__TWIST_MUX_TEST_FIXTURE_HPP_
+
+#include <gtest/gtest.h>
+
+#include <rclcpp/rclcpp.hpp>
+#include <geometry_msgs/msg/twist.hpp>
+#include <std_msgs/msg/bool.hpp>
+
+#include <twist_mux/topic_handle.hpp>
+#include <twist_mux/twist_mux.hpp>
+#include <twist_mux/twist_mux_diagnostics_status.hpp>
+#include <twist_mux/msg/active_source.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace twist_mux_test
+{
+/**
+ * @brief The TestTwistMux class is a mux which publishes on an OutputT
+ * instead of its output, and whose handle callbacks and timers are run by
+ * the tests instead of an executor.
+ */
+template<class OutputT>
+class TestTwistMux : public twist_mux::TwistMux
+{
+public:
+  explicit TestTwistMux(const rclcpp::NodeOptions & options)
+  : TwistMux(options)
+  {
+    replaceOutput();
+  }
+
+  TestTwistMux(const Configuration & configuration, const rclcpp::NodeOptions & options)
+  : TwistMux(configuration, options)
+  {
+    replaceOutput();
+  }
+
+  /**
+   * @brief forward Runs the subscription callback of a velocity handle
+   */
+  void forward(std::size_t index, const geometry_msgs::msg::Twist::ConstSharedPtr & msg)
+  {
+    velocity_hs_->at(index)->callback(msg);
+  }
+
+  /**
+   * @brief lock Runs the subscription callback of a lock handle
+   */
+  void lock(std::size_t index, const std_msgs::msg::Bool::ConstSharedPtr & msg)
+  {
+    lock_hs_->at(index)->callback(msg);
+  }
+
+  /**
+   * @brief tick Runs the expiry timer
+   */
+  void tick()
+  {
+    checkExpiry();
+  }
+
+  /**
+   * @brief spinUntil Runs the timers of the mux until 'done' returns true
+   * @return false if it has not within a second
+   */
+  template<typename PredicateT>
+  bool spinUntil(PredicateT done)
+  {
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(shared_from_this());
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!done()) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      executor.spin_some();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  /**
+   * @brief reconfigure Sets parameters, and runs the reconfiguration they
+   * schedule
+   * @return false if the reconfiguration has not run within a second
+   */
+  bool reconfigure(const std::vector<rclcpp::Parameter> & parameters)
+  {
+    const auto velocity_hs = velocity_hs_;
+    for (const auto & result : set_parameters(parameters)) {
+      if (!result.successful) {
+        return false;
+      }
+    }
+    return spinUntil([this, &velocity_hs]() {return velocity_hs_ != velocity_hs;});
+  }
+
+  const twist_mux::VelocityTopicHandle & velocityHandle(std::size_t index) const
+  {
+    return *velocity_hs_->at(index);
+  }
+
+  OutputT & output()
+  {
+    return *test_output_;
+  }
+
+  /**
+   * @brief activeSource Last message published on ~/active_source
+   */
+  const twist_mux::msg::ActiveSource & activeSource() const
+  {
+    return active_source_msg_;
+  }
+
+  /**
+   * @brief status Status of the last diagnostics update
+   */
+  const twist_mux::TwistMuxDiagnosticsStatus & status() const
+  {
+    return *status_;
+  }
+
+private:
+  void replaceOutput()
+  {
+    auto output = std::make_unique<OutputT>();
+    test_output_ = output.get();
+    output_ = std::move(output);
+  }
+
+  OutputT * test_output_;
+};
+
+/**
+ * @brief The TwistMuxTest class initializes rclcpp for the tests of a mux
+ */
+class TwistMuxTest : public ::testing::Test
+{
+protected:
+  static void SetUpTestSuite()
+  {
+    rclcpp::init(0, nullptr);
+  }
+
+  static void TearDownTestSuite()
+  {
+    rclcpp::shutdown();
+  }
+
+  template<class OutputT>
+  std::shared_ptr<TestTwistMux<OutputT>> createMux(
+    const std::vector<rclcpp::Parameter> & parameters)
+  {
+    rclcpp::NodeOptions options;
+    options.parameter_overrides(parameters);
+    return std::make_shared<TestTwistMux<OutputT>>(options);
+  }
+
+  /**
+   * @brief createMux Creates a mux with a compiled configuration
+   */
+  template<class OutputT>
+  std::shared_ptr<TestTwistMux<OutputT>> createMux(
+    const twist_mux::TwistMux::Configuration & configuration)
+  {
+    return std::make_shared<TestTwistMux<OutputT>>(configuration, rclcpp::NodeOptions());
+  }
+};
+}  // namespace twist_mux_test
+
+#endif  // TEST__TWIST_MUX_TEST_FIXTURE_HPP_